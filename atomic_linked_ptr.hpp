@@ -0,0 +1,121 @@
+#ifndef ATOMIC_LINKED_PTR_H
+#define ATOMIC_LINKED_PTR_H
+
+#include "concurrent_linked_ptr.hpp"
+
+#include <atomic>
+
+namespace smart_ptr
+{
+    // A slot many threads can read and replace, shaped like
+    // std::atomic<std::shared_ptr<T>>. Every slot has its own spinlock that
+    // is held only while the stored owner is copied out or swapped, so
+    // readers of different slots never contend. Values are
+    // concurrent_linked_ptr, since owners handed to readers are released
+    // on their threads while the slot keeps the ring alive.
+    template <typename T>
+    class atomic_linked_ptr
+    {
+    public:
+        using value_type = concurrent_linked_ptr<T>;
+
+    private:
+        mutable details::ring_lock lock;
+        value_type value;
+
+        class slot_guard
+        {
+        private:
+            details::ring_lock& lock;
+
+        public:
+            explicit slot_guard(details::ring_lock& lock) noexcept : lock(lock)
+            {
+                lock.lock();
+            }
+
+            slot_guard(slot_guard const&) = delete;
+            slot_guard& operator=(slot_guard const&) = delete;
+
+            ~slot_guard()
+            {
+                lock.unlock();
+            }
+        };
+
+    public:
+        static constexpr bool is_always_lock_free = false;
+
+        constexpr atomic_linked_ptr() noexcept = default;
+
+        atomic_linked_ptr(value_type desired) noexcept : value(std::move(desired)) {}
+
+        atomic_linked_ptr(atomic_linked_ptr const&) = delete;
+        atomic_linked_ptr& operator=(atomic_linked_ptr const&) = delete;
+
+        bool is_lock_free() const noexcept
+        {
+            return false;
+        }
+
+        value_type load(std::memory_order = std::memory_order_seq_cst) const
+        {
+            slot_guard guard(lock);
+            return value;
+        }
+
+        operator value_type() const
+        {
+            return load();
+        }
+
+        void store(value_type desired, std::memory_order = std::memory_order_seq_cst) noexcept
+        {
+            {
+                slot_guard guard(lock);
+                value.swap(desired);
+            }
+            // The previous value is released here, outside the slot lock.
+        }
+
+        atomic_linked_ptr& operator=(value_type desired) noexcept
+        {
+            store(std::move(desired));
+            return *this;
+        }
+
+        value_type exchange(value_type desired, std::memory_order = std::memory_order_seq_cst) noexcept
+        {
+            slot_guard guard(lock);
+            value.swap(desired);
+            return desired;
+        }
+
+        bool compare_exchange_strong(value_type& expected, value_type desired,
+                                     std::memory_order = std::memory_order_seq_cst,
+                                     std::memory_order = std::memory_order_seq_cst)
+        {
+            value_type previous;
+            {
+                slot_guard guard(lock);
+                if (value.get() == expected.get())
+                {
+                    value.swap(desired);
+                    return true;
+                }
+                previous = value;
+            }
+            expected.swap(previous);
+            return false;
+        }
+
+        bool compare_exchange_weak(value_type& expected, value_type desired,
+                                   std::memory_order success = std::memory_order_seq_cst,
+                                   std::memory_order failure = std::memory_order_seq_cst)
+        {
+            return compare_exchange_strong(expected, std::move(desired), success, failure);
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,177 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace bench
+{
+    template <typename T>
+    inline void do_not_optimize(T const& value)
+    {
+        asm volatile("" : : "r"(&value) : "memory");
+    }
+
+    inline void clobber_memory()
+    {
+        asm volatile("" : : : "memory");
+    }
+
+    class perf_counter
+    {
+    private:
+        int fd = -1;
+
+    public:
+        perf_counter(std::uint32_t type, std::uint64_t config)
+        {
+#if defined(__linux__)
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+            (void) type;
+            (void) config;
+#endif
+        }
+
+        perf_counter(perf_counter const&) = delete;
+        perf_counter& operator=(perf_counter const&) = delete;
+
+        ~perf_counter()
+        {
+#if defined(__linux__)
+            if (fd >= 0)
+                close(fd);
+#endif
+        }
+
+        bool valid() const noexcept
+        {
+            return fd >= 0;
+        }
+
+        void start()
+        {
+#if defined(__linux__)
+            if (fd >= 0)
+            {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+#endif
+        }
+
+        std::uint64_t stop()
+        {
+            std::uint64_t value = 0;
+#if defined(__linux__)
+            if (fd >= 0)
+            {
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+                if (read(fd, &value, sizeof(value)) != sizeof(value))
+                    value = 0;
+            }
+#endif
+            return value;
+        }
+    };
+
+    inline std::uint64_t timestamp_counter()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    struct result
+    {
+        double ns = 0;
+        double cycles = -1;
+        double instructions = -1;
+    };
+
+    // Runs `body` once; `body` is expected to perform `ops` operations.
+    // Cycles fall back to the time stamp counter when hardware counters
+    // are unavailable, instructions are reported as -1 in that case.
+    template <typename F>
+    result measure(std::size_t ops, F&& body)
+    {
+#if defined(__linux__)
+        perf_counter cycles(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        perf_counter instructions(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+#else
+        perf_counter cycles(0, 0);
+        perf_counter instructions(0, 0);
+#endif
+        std::uint64_t tsc_start = timestamp_counter();
+        auto time_start = std::chrono::steady_clock::now();
+        cycles.start();
+        instructions.start();
+
+        body();
+
+        std::uint64_t instructions_count = instructions.stop();
+        std::uint64_t cycles_count = cycles.stop();
+        auto time_end = std::chrono::steady_clock::now();
+        std::uint64_t tsc_end = timestamp_counter();
+
+        result res;
+        double n = static_cast<double>(ops ? ops : 1);
+        res.ns = std::chrono::duration<double, std::nano>(time_end - time_start).count() / n;
+        if (cycles.valid())
+            res.cycles = static_cast<double>(cycles_count) / n;
+        else if (tsc_end != tsc_start)
+            res.cycles = static_cast<double>(tsc_end - tsc_start) / n;
+        if (instructions.valid())
+            res.instructions = static_cast<double>(instructions_count) / n;
+        return res;
+    }
+
+    template <typename F>
+    result best_of(std::size_t repeats, std::size_t ops, F&& body)
+    {
+        result best;
+        for (std::size_t i = 0; i < repeats; ++i)
+        {
+            result current = measure(ops, body);
+            if (i == 0 || current.ns < best.ns)
+                best = current;
+        }
+        return best;
+    }
+
+    inline void print_header()
+    {
+        std::printf("%-40s %12s %12s %14s\n", "benchmark", "ns/op", "cycles/op", "instr/op");
+    }
+
+    inline void print(char const* name, result const& res)
+    {
+        std::printf("%-40s %12.2f %12.2f %14.2f\n", name, res.ns, res.cycles, res.instructions);
+    }
+}
+
+#endif
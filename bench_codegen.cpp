@@ -0,0 +1,128 @@
+#include "bench.hpp"
+#include "linked_ptr.hpp"
+
+#include <vector>
+
+using namespace smart_ptr;
+
+namespace
+{
+    // The previous ring layout, kept to compare code generation against.
+    struct volatile_node
+    {
+        volatile volatile_node* l = nullptr;
+        volatile volatile_node* r = nullptr;
+
+        void attach(volatile volatile_node* copy) volatile
+        {
+            copy->l = this;
+            copy->r = r;
+            if (r)
+                r->l = copy;
+            r = copy;
+        }
+
+        void detach() volatile
+        {
+            if (l)
+                l->r = r;
+            if (r)
+                r->l = l;
+            l = nullptr;
+            r = nullptr;
+        }
+    };
+
+    template <typename T>
+    class volatile_linked_ptr
+    {
+    private:
+        mutable volatile volatile_node node;
+        T* pointer;
+
+    public:
+        explicit volatile_linked_ptr(T* pointer) : node(), pointer(pointer) {}
+
+        volatile_linked_ptr(volatile_linked_ptr const& other) : node(), pointer(other.pointer)
+        {
+            other.node.attach(&node);
+        }
+
+        ~volatile_linked_ptr()
+        {
+            if (!node.l && !node.r)
+                delete pointer;
+            node.detach();
+        }
+
+        T* get() const noexcept
+        {
+            return pointer;
+        }
+    };
+
+    std::size_t const ops = 1 << 22;
+    std::size_t const repeats = 5;
+
+    template <typename Ptr>
+    void copy_destroy(char const* name)
+    {
+        Ptr root(new int(42));
+        bench::result res = bench::best_of(repeats, ops, [&]
+        {
+            for (std::size_t i = 0; i < ops; ++i)
+            {
+                Ptr copy(root);
+                bench::do_not_optimize(copy);
+            }
+        });
+        bench::print(name, res);
+    }
+
+    template <typename Ptr>
+    void copy_destroy_shared_ring(char const* name)
+    {
+        Ptr root(new int(42));
+        std::vector<Ptr> owners(64, root);
+        bench::result res = bench::best_of(repeats, ops, [&]
+        {
+            for (std::size_t i = 0; i < ops; ++i)
+            {
+                Ptr copy(owners[i & 63]);
+                bench::do_not_optimize(copy);
+            }
+        });
+        bench::print(name, res);
+    }
+
+    template <typename Ptr>
+    void copy_chain(char const* name)
+    {
+        std::size_t const length = 1024;
+        bench::result res = bench::best_of(repeats, ops, [&]
+        {
+            for (std::size_t i = 0; i < ops / length; ++i)
+            {
+                std::vector<Ptr> chain;
+                chain.reserve(length);
+                chain.emplace_back(new int(42));
+                for (std::size_t j = 1; j < length; ++j)
+                    chain.push_back(chain.back());
+                bench::do_not_optimize(chain);
+            }
+        });
+        bench::print(name, res);
+    }
+}
+
+int main()
+{
+    bench::print_header();
+    copy_destroy<volatile_linked_ptr<int>>("copy+destroy/volatile");
+    copy_destroy<linked_ptr<int>>("copy+destroy/linked_ptr");
+    copy_destroy_shared_ring<volatile_linked_ptr<int>>("copy+destroy ring64/volatile");
+    copy_destroy_shared_ring<linked_ptr<int>>("copy+destroy ring64/linked_ptr");
+    copy_chain<volatile_linked_ptr<int>>("chain copy+destroy/volatile");
+    copy_chain<linked_ptr<int>>("chain copy+destroy/linked_ptr");
+    return 0;
+}
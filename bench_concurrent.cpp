@@ -0,0 +1,121 @@
+#include "bench.hpp"
+#include "concurrent_linked_ptr.hpp"
+#include "lockfree_linked_ptr.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace smart_ptr;
+
+namespace
+{
+    std::size_t const ops_per_thread = 1 << 18;
+
+    // Every thread starts from its own owner of one of `roots`, spread
+    // over them, and repeatedly copies and drops it; returns total
+    // operations per second.
+    template <typename Ptr>
+    double throughput(std::size_t thread_count, std::vector<Ptr> const& roots)
+    {
+        std::atomic<std::size_t> ready{0};
+        std::atomic<bool> go{false};
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < thread_count; ++t)
+        {
+            threads.emplace_back([&, t]
+            {
+                Ptr local(roots[t * roots.size() / thread_count]);
+                ready.fetch_add(1);
+                while (!go.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+                for (std::size_t i = 0; i < ops_per_thread; ++i)
+                {
+                    Ptr copy(local);
+                    bench::do_not_optimize(copy);
+                }
+            });
+        }
+        while (ready.load() != thread_count)
+            std::this_thread::yield();
+        auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto& thread : threads)
+            thread.join();
+        auto end = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+        return static_cast<double>(thread_count * ops_per_thread) / seconds;
+    }
+
+    template <typename Ptr>
+    void run(char const* name, std::size_t thread_count, std::size_t objects)
+    {
+        std::vector<Ptr> roots;
+        for (std::size_t i = 0; i < objects; ++i)
+            roots.emplace_back(new int(static_cast<int>(i)));
+        double ops = throughput(thread_count, roots);
+        std::printf("%-24s threads=%-3zu objects=%-3zu %10.2f Mops/s\n", name, thread_count, objects, ops / 1e6);
+    }
+
+    // Copies and drops owners spread over a ring of `ring_size` owners of
+    // one object, then releases the whole ring from all threads, each
+    // taking every thread_count-th owner.
+    template <typename Ptr>
+    void run_large_ring(char const* name, std::size_t thread_count, std::size_t ring_size)
+    {
+        std::vector<Ptr> ring(1, Ptr(new int(0)));
+        for (std::size_t i = 1; i < ring_size; ++i)
+            ring.push_back(ring[i - 1]);
+        double ops = throughput(thread_count, ring);
+
+        std::atomic<std::size_t> ready{0};
+        std::atomic<bool> go{false};
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < thread_count; ++t)
+        {
+            threads.emplace_back([&, t]
+            {
+                ready.fetch_add(1);
+                while (!go.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+                for (std::size_t i = t; i < ring_size; i += thread_count)
+                    ring[i] = Ptr();
+            });
+        }
+        while (ready.load() != thread_count)
+            std::this_thread::yield();
+        auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto& thread : threads)
+            thread.join();
+        auto end = std::chrono::steady_clock::now();
+        double release = std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(ring_size);
+        std::printf("%-24s threads=%-3zu ring=%-6zu %10.2f Mops/s %8.1f ns/release\n", name, thread_count, ring_size,
+                    ops / 1e6, release);
+    }
+}
+
+int main()
+{
+    for (std::size_t threads = 1; threads <= 64; threads *= 2)
+    {
+        run<concurrent_linked_ptr<int>>("concurrent_linked_ptr", threads, 1);
+        run<lockfree_linked_ptr<int>>("lockfree_linked_ptr", threads, 1);
+        run<std::shared_ptr<int>>("shared_ptr", threads, 1);
+        run<concurrent_linked_ptr<int>>("concurrent_linked_ptr", threads, threads);
+        run<lockfree_linked_ptr<int>>("lockfree_linked_ptr", threads, threads);
+        run<std::shared_ptr<int>>("shared_ptr", threads, threads);
+    }
+    for (std::size_t threads = 1; threads <= 16; threads *= 4)
+    {
+        for (std::size_t ring_size = 1024; ring_size <= 16384; ring_size *= 4)
+        {
+            run_large_ring<lockfree_linked_ptr<int>>("lockfree_linked_ptr", threads, ring_size);
+            run_large_ring<std::shared_ptr<int>>("shared_ptr", threads, ring_size);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,342 @@
+#include "bench.hpp"
+#include "linked_ptr.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace smart_ptr;
+
+namespace
+{
+    template <typename Ptr>
+    struct pointer_kind;
+
+    template <>
+    struct pointer_kind<linked_ptr<int>>
+    {
+        static constexpr char const* name = "linked_ptr";
+        static constexpr bool copyable = true;
+    };
+
+    template <>
+    struct pointer_kind<std::shared_ptr<int>>
+    {
+        static constexpr char const* name = "shared_ptr";
+        static constexpr bool copyable = true;
+    };
+
+    template <>
+    struct pointer_kind<std::unique_ptr<int>>
+    {
+        static constexpr char const* name = "unique_ptr";
+        static constexpr bool copyable = false;
+    };
+
+    // Keeps every owner on its own cache lines, like owners embedded in
+    // separately allocated objects.
+    template <typename Ptr>
+    struct alignas(128) slot
+    {
+        Ptr owner;
+    };
+
+    enum class cache
+    {
+        hot,
+        cold
+    };
+
+    char const* cache_name(cache c)
+    {
+        return c == cache::hot ? "hot" : "cold";
+    }
+
+    std::size_t const ops = 1 << 16;
+    std::size_t const repeats = 3;
+    std::size_t const min_slots = 1024;
+    std::size_t const hot_slots = 64;
+
+    bool table = false;
+
+    // Walks a buffer larger than the last level cache.
+    void evict_caches()
+    {
+        static std::vector<char> buffer(64 << 20);
+        for (std::size_t i = 0; i < buffer.size(); i += 64)
+            buffer[i]++;
+        bench::do_not_optimize(buffer.data());
+    }
+
+    void report(char const* operation, char const* pointer, std::size_t ring_size, cache c, bench::result const& res)
+    {
+        if (table)
+        {
+            std::string name = std::string(operation) + "/" + pointer + "/ring " + std::to_string(ring_size) + "/" + cache_name(c);
+            bench::print(name.c_str(), res);
+        }
+        else
+        {
+            std::printf("%s,%s,%zu,%s,%.3f,%.3f,%.3f\n", operation, pointer, ring_size, cache_name(c),
+                        res.ns, res.cycles, res.instructions);
+        }
+    }
+
+    // Owners of max(ring_size, min_slots) / ring_size objects, every
+    // object owned by ring_size slots. Cold slots are shuffled in memory.
+    template <typename Ptr>
+    class fixture
+    {
+    private:
+        std::mt19937 random;
+        std::vector<std::unique_ptr<slot<Ptr>>> slots;
+
+    public:
+        std::vector<std::size_t> picks;
+
+        fixture(std::size_t ring_size, cache c) : random(static_cast<std::mt19937::result_type>(ring_size))
+        {
+            std::size_t count = std::max(ring_size, min_slots);
+            std::size_t objects = count / ring_size;
+            for (std::size_t i = 0; i < objects; ++i)
+                slots.emplace_back(new slot<Ptr>{Ptr(new int(static_cast<int>(i)))});
+            if constexpr (pointer_kind<Ptr>::copyable)
+            {
+                for (std::size_t i = objects; i < count; ++i)
+                    slots.emplace_back(new slot<Ptr>{slots[i % objects]->owner});
+            }
+            if (c == cache::cold)
+                std::shuffle(slots.begin(), slots.end(), random);
+
+            std::size_t range = c == cache::hot ? std::min(hot_slots, slots.size()) : slots.size();
+            picks.resize(ops);
+            for (auto& pick : picks)
+                pick = random() % range;
+        }
+
+        Ptr& operator[](std::size_t i)
+        {
+            return slots[i]->owner;
+        }
+
+        std::size_t size() const noexcept
+        {
+            return slots.size();
+        }
+
+        // Releases the owners in random order.
+        void destroy_all()
+        {
+            std::shuffle(slots.begin(), slots.end(), random);
+            for (auto& s : slots)
+                s->owner = Ptr();
+        }
+    };
+
+    // Runs `body(fixture)` after a fresh setup on each repeat and reports
+    // the best run.
+    template <typename Ptr, typename Body>
+    void run(char const* operation, std::size_t ring_size, cache c, Body body)
+    {
+        bench::result best;
+        for (std::size_t r = 0; r < repeats; ++r)
+        {
+            fixture<Ptr> f(ring_size, c);
+            std::size_t count = ops;
+            auto prepared = body(f, count);
+            if (c == cache::cold)
+                evict_caches();
+            bench::result res = bench::measure(count, prepared);
+            if (r == 0 || res.ns < best.ns)
+                best = res;
+        }
+        report(operation, pointer_kind<Ptr>::name, ring_size, c, best);
+    }
+
+    template <typename Ptr>
+    void construct(cache c)
+    {
+        run<Ptr>("construct_destroy", 1, c, [](fixture<Ptr>&, std::size_t&)
+        {
+            return []
+            {
+                for (std::size_t i = 0; i < ops; ++i)
+                {
+                    Ptr p(new int(static_cast<int>(i)));
+                    bench::do_not_optimize(p);
+                }
+            };
+        });
+    }
+
+    template <typename Ptr>
+    void copy(std::size_t ring_size, cache c)
+    {
+        run<Ptr>("copy", ring_size, c, [](fixture<Ptr>& f, std::size_t&)
+        {
+            return [&f]
+            {
+                for (std::size_t i = 0; i < ops; ++i)
+                {
+                    Ptr p(f[f.picks[i]]);
+                    bench::do_not_optimize(p);
+                }
+            };
+        });
+    }
+
+    template <typename Ptr>
+    void assign(std::size_t ring_size, cache c)
+    {
+        run<Ptr>("assign", ring_size, c, [](fixture<Ptr>& f, std::size_t&)
+        {
+            return [&f]
+            {
+                for (std::size_t i = 0; i + 1 < ops; ++i)
+                {
+                    f[f.picks[i]] = f[f.picks[i + 1]];
+                    bench::clobber_memory();
+                }
+            };
+        });
+    }
+
+    template <typename Ptr>
+    void swap(std::size_t ring_size, cache c)
+    {
+        run<Ptr>("swap", ring_size, c, [](fixture<Ptr>& f, std::size_t&)
+        {
+            return [&f]
+            {
+                for (std::size_t i = 0; i + 1 < ops; ++i)
+                {
+                    f[f.picks[i]].swap(f[f.picks[i + 1]]);
+                    bench::clobber_memory();
+                }
+            };
+        });
+    }
+
+    // Releases copies joined to the fixture's rings; the copies are made
+    // before the measurement.
+    template <typename Ptr>
+    void reset(std::size_t ring_size, cache c)
+    {
+        auto copies = std::make_shared<std::vector<Ptr>>();
+        run<Ptr>("reset", ring_size, c, [copies](fixture<Ptr>& f, std::size_t&)
+        {
+            copies->clear();
+            copies->reserve(ops);
+            for (std::size_t i = 0; i < ops; ++i)
+                copies->push_back(f[f.picks[i]]);
+            return [copies]
+            {
+                for (auto& p : *copies)
+                {
+                    p.reset();
+                    bench::clobber_memory();
+                }
+            };
+        });
+    }
+
+    // Every owner of the fixture, the last owner of each object included.
+    template <typename Ptr>
+    void destroy(std::size_t ring_size, cache c)
+    {
+        run<Ptr>("destroy", ring_size, c, [](fixture<Ptr>& f, std::size_t& count)
+        {
+            count = f.size();
+            return [&f]
+            {
+                f.destroy_all();
+            };
+        });
+    }
+
+    // Growing a vector relocates its owners; ns per element.
+    template <typename Ptr>
+    void vector_push_back(std::size_t ring_size, cache c)
+    {
+        auto v = std::make_shared<std::vector<Ptr>>();
+        run<Ptr>("vector_push_back", ring_size, c, [v](fixture<Ptr>& f, std::size_t& count)
+        {
+            v->clear();
+            v->shrink_to_fit();
+            count = f.size();
+            return [v, &f]
+            {
+                for (std::size_t i = 0; i < f.size(); ++i)
+                {
+                    if constexpr (pointer_kind<Ptr>::copyable)
+                        v->push_back(f[i]);
+                    else
+                        v->push_back(std::move(f[i]));
+                }
+            };
+        });
+    }
+
+    template <typename Ptr>
+    void vector_copy(std::size_t ring_size, cache c)
+    {
+        auto v = std::make_shared<std::vector<Ptr>>();
+        run<Ptr>("vector_copy", ring_size, c, [v](fixture<Ptr>& f, std::size_t& count)
+        {
+            v->clear();
+            for (std::size_t i = 0; i < f.size(); ++i)
+                v->push_back(f[i]);
+            count = f.size();
+            return [v]
+            {
+                std::vector<Ptr> copy(*v);
+                bench::do_not_optimize(copy.data());
+            };
+        });
+    }
+
+    template <typename Ptr>
+    void suite(std::size_t ring_size, cache c)
+    {
+        if (ring_size == 1)
+            construct<Ptr>(c);
+        if constexpr (pointer_kind<Ptr>::copyable)
+        {
+            copy<Ptr>(ring_size, c);
+            assign<Ptr>(ring_size, c);
+            reset<Ptr>(ring_size, c);
+            vector_copy<Ptr>(ring_size, c);
+        }
+        swap<Ptr>(ring_size, c);
+        destroy<Ptr>(ring_size, c);
+        vector_push_back<Ptr>(ring_size, c);
+    }
+}
+
+// Prints one CSV row per measurement; --table prints aligned columns.
+int main(int argc, char** argv)
+{
+    for (int i = 1; i < argc; ++i)
+        if (std::strcmp(argv[i], "--table") == 0)
+            table = true;
+
+    if (table)
+        bench::print_header();
+    else
+        std::printf("operation,pointer,ring_size,cache,ns_per_op,cycles_per_op,instructions_per_op\n");
+
+    for (cache c : {cache::hot, cache::cold})
+    {
+        for (std::size_t ring_size = 1; ring_size <= 100000; ring_size *= 10)
+        {
+            suite<linked_ptr<int>>(ring_size, c);
+            suite<std::shared_ptr<int>>(ring_size, c);
+            if (ring_size == 1)
+                suite<std::unique_ptr<int>>(ring_size, c);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include "bench.hpp"
+#include "linked_ptr.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace smart_ptr;
+
+namespace
+{
+    template <std::size_t Threshold>
+    struct payload
+    {
+        int value = 42;
+    };
+}
+
+namespace smart_ptr
+{
+    template <std::size_t Threshold>
+    struct linked_ptr_traits<payload<Threshold>>
+    {
+        static constexpr std::size_t promotion_threshold = Threshold;
+        static constexpr bool demote = true;
+    };
+}
+
+namespace
+{
+    // Keeps every owner on its own cache lines, like owners embedded in
+    // separately allocated connection objects.
+    template <typename T>
+    struct alignas(128) padded_owner
+    {
+        linked_ptr<T> owner;
+    };
+
+    std::size_t const ops = 1 << 20;
+    std::size_t const repeats = 3;
+
+    template <std::size_t Threshold>
+    void copy_destroy(std::size_t ring_size)
+    {
+        using T = payload<Threshold>;
+        std::mt19937 random(ring_size);
+        std::vector<std::unique_ptr<padded_owner<T>>> owners;
+        owners.emplace_back(new padded_owner<T>{linked_ptr<T>(new T())});
+        for (std::size_t i = 1; i < ring_size; ++i)
+            owners.emplace_back(new padded_owner<T>{owners[random() % owners.size()]->owner});
+        std::shuffle(owners.begin(), owners.end(), random);
+
+        std::vector<std::size_t> picks(ops);
+        for (auto& pick : picks)
+            pick = random() % ring_size;
+
+        bench::result res = bench::best_of(repeats, ops, [&]
+        {
+            for (std::size_t i = 0; i < ops; ++i)
+            {
+                linked_ptr<T> copy(owners[picks[i]]->owner);
+                bench::do_not_optimize(copy);
+            }
+        });
+        std::string name = "ring " + std::to_string(ring_size) + "/threshold " + std::to_string(Threshold);
+        bench::print(name.c_str(), res);
+    }
+}
+
+int main()
+{
+    bench::print_header();
+    for (std::size_t ring_size = 2; ring_size <= 4096; ring_size *= 2)
+    {
+        copy_destroy<0>(ring_size);
+        copy_destroy<8>(ring_size);
+        copy_destroy<64>(ring_size);
+    }
+    return 0;
+}
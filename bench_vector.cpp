@@ -0,0 +1,120 @@
+#include "bench.hpp"
+#include "linked_ptr.hpp"
+#include "linked_ptr_algorithm.hpp"
+#include "linked_ptr_vector.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace smart_ptr;
+
+namespace
+{
+    std::size_t const ring_size = 4;
+    std::size_t const middle_erases = 16;
+
+    // Every ring_size consecutive elements share one object, so growth
+    // moves whole rings as well as owners whose neighbours stay behind.
+    template <typename Vector>
+    void fill(Vector& v, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            if (i % ring_size == 0)
+                v.emplace_back(new int(static_cast<int>(i)));
+            else
+                v.push_back(v.back());
+        }
+    }
+
+    struct std_algorithms
+    {
+        template <typename Ptr>
+        static void sort(Ptr* first, Ptr* last)
+        {
+            std::sort(first, last);
+        }
+
+        template <typename Vector>
+        static void clear(Vector& v)
+        {
+            v.clear();
+        }
+    };
+
+    struct ring_algorithms
+    {
+        template <typename Ptr>
+        static void sort(Ptr* first, Ptr* last)
+        {
+            smart_ptr::sort(first, last);
+        }
+
+        template <typename Ptr>
+        static void clear(std::vector<Ptr>& v)
+        {
+            smart_ptr::clear(v);
+        }
+
+        template <typename T>
+        static void clear(linked_ptr_vector<T>& v)
+        {
+            v.clear();
+        }
+    };
+
+    template <typename Vector, typename Algorithms>
+    void run(char const* name, std::size_t n)
+    {
+        Vector v;
+        bench::result growth = bench::measure(n, [&]
+        {
+            fill(v, n);
+            bench::do_not_optimize(v.data());
+        });
+        std::shuffle(v.data(), v.data() + v.size(), std::mt19937(static_cast<std::mt19937::result_type>(n)));
+        bench::result sorting = bench::measure(n, [&]
+        {
+            Algorithms::sort(v.data(), v.data() + v.size());
+            bench::do_not_optimize(v.data());
+        });
+        bench::result erase = bench::measure(middle_erases, [&]
+        {
+            for (std::size_t i = 0; i < middle_erases; ++i)
+                v.erase(v.begin() + static_cast<std::ptrdiff_t>(v.size() / 2));
+            bench::do_not_optimize(v.data());
+        });
+        std::size_t remaining = v.size();
+        bench::result clear = bench::measure(remaining, [&]
+        {
+            Algorithms::clear(v);
+            bench::do_not_optimize(v.data());
+        });
+        std::string label = std::string("push_back/") + name + "/" + std::to_string(n);
+        bench::print(label.c_str(), growth);
+        label = std::string("sort/") + name + "/" + std::to_string(n);
+        bench::print(label.c_str(), sorting);
+        label = std::string("erase middle/") + name + "/" + std::to_string(n);
+        bench::print(label.c_str(), erase);
+        label = std::string("clear/") + name + "/" + std::to_string(n);
+        bench::print(label.c_str(), clear);
+    }
+}
+
+// Usage: bench-vector [max elements], 10^8 by default.
+int main(int argc, char** argv)
+{
+    std::size_t max = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000000;
+    bench::print_header();
+    for (std::size_t n = 1000000; n <= max; n *= 10)
+    {
+        run<std::vector<linked_ptr<int>>, std_algorithms>("std::vector", n);
+        run<std::vector<linked_ptr<int>>, ring_algorithms>("std::vector+ring algorithms", n);
+        run<linked_ptr_vector<int>, ring_algorithms>("linked_ptr_vector", n);
+    }
+    return 0;
+}
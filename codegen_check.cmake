@@ -0,0 +1,20 @@
+# Usage: cmake -DPLAIN=<asm> -DSTATS=<asm> -P codegen_check.cmake
+# Fails if the assembly built without statistics refers to them or to
+# thread-local storage, or if the one built with them does not.
+
+file(READ "${PLAIN}" plain)
+file(READ "${STATS}" stats)
+
+foreach(pattern "stats" "__tls_get_addr" "@tpoff" "@tlsgd")
+    string(FIND "${plain}" "${pattern}" position)
+    if(NOT position EQUAL -1)
+        message(FATAL_ERROR "codegen check: ${PLAIN} contains '${pattern}' with statistics disabled")
+    endif()
+endforeach()
+
+string(FIND "${stats}" "stats" position)
+if(position EQUAL -1)
+    message(FATAL_ERROR "codegen check: ${STATS} shows no statistics code, the check is not effective")
+endif()
+
+message(STATUS "codegen check: statistics hooks compile away when disabled")
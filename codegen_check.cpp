@@ -0,0 +1,37 @@
+// Compiled to assembly by the codegen-check target, once as is and once
+// with CODEGEN_CHECK_STATS; codegen_check.cmake verifies that the first
+// contains no trace of the statistics hooks.
+#include "linked_ptr.hpp"
+
+using namespace smart_ptr;
+
+struct payload
+{
+    int value;
+};
+
+#ifdef CODEGEN_CHECK_STATS
+namespace smart_ptr
+{
+    template <>
+    struct linked_ptr_traits<payload>
+    {
+        static constexpr std::size_t promotion_threshold = 0;
+        static constexpr bool demote = true;
+        static constexpr bool collect_stats = true;
+    };
+}
+#endif
+
+extern "C" void copy_destroy(linked_ptr<payload> const& p, void (*use)(linked_ptr<payload> const&))
+{
+    linked_ptr<payload> copy(p);
+    use(copy);
+}
+
+extern "C" void assign_swap_reset(linked_ptr<payload>& a, linked_ptr<payload>& b, payload* fresh)
+{
+    a = b;
+    a.swap(b);
+    b.reset(fresh);
+}
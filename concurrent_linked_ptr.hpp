@@ -0,0 +1,300 @@
+#ifndef CONCURRENT_LINKED_PTR_H
+#define CONCURRENT_LINKED_PTR_H
+
+#include "linked_ptr.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+namespace smart_ptr
+{
+    namespace details
+    {
+        class ring_lock
+        {
+        private:
+            std::atomic<bool> locked{false};
+
+        public:
+            void lock() noexcept
+            {
+                for (unsigned spins = 0; locked.exchange(true, std::memory_order_acquire); ++spins)
+                {
+                    while (locked.load(std::memory_order_relaxed))
+                    {
+                        if (++spins > 64)
+                        {
+                            std::this_thread::yield();
+                            spins = 0;
+                        }
+                    }
+                }
+            }
+
+            void unlock() noexcept
+            {
+                locked.store(false, std::memory_order_release);
+            }
+        };
+
+        struct alignas(64) padded_ring_lock : ring_lock {};
+
+        constexpr std::size_t ring_lock_count = 256;
+
+        // Every ring is guarded by the stripe its pointee's address hashes
+        // to, so unrelated objects rarely contend.
+        inline padded_ring_lock ring_locks[ring_lock_count];
+
+        inline ring_lock& ring_lock_for(void const* pointer) noexcept
+        {
+            auto address = reinterpret_cast<std::uintptr_t>(pointer);
+            auto hash = static_cast<std::uint64_t>(address >> 4) * 0x9E3779B97F4A7C15ull;
+            return ring_locks[hash >> 56];
+        }
+
+        class ring_lock_guard
+        {
+        private:
+            ring_lock& lock;
+
+        public:
+            explicit ring_lock_guard(void const* pointer) noexcept : lock(ring_lock_for(pointer))
+            {
+                lock.lock();
+            }
+
+            ring_lock_guard(ring_lock_guard const&) = delete;
+            ring_lock_guard& operator=(ring_lock_guard const&) = delete;
+
+            ~ring_lock_guard()
+            {
+                lock.unlock();
+            }
+        };
+
+        // Locks the stripes of two rings in a fixed order.
+        class ring_lock_pair_guard
+        {
+        private:
+            ring_lock* first;
+            ring_lock* second;
+
+        public:
+            ring_lock_pair_guard(void const* a, void const* b) noexcept
+                : first(&ring_lock_for(a)), second(&ring_lock_for(b))
+            {
+                if (first == second)
+                    second = nullptr;
+                else if (second < first)
+                    std::swap(first, second);
+                first->lock();
+                if (second)
+                    second->lock();
+            }
+
+            ring_lock_pair_guard(ring_lock_pair_guard const&) = delete;
+            ring_lock_pair_guard& operator=(ring_lock_pair_guard const&) = delete;
+
+            ~ring_lock_pair_guard()
+            {
+                if (second)
+                    second->unlock();
+                first->unlock();
+            }
+        };
+    }
+
+    // Owners of one object may be copied, moved and destroyed from
+    // different threads. Ring mutations take the lock stripe of the
+    // pointee; a single concurrent_linked_ptr instance is still not safe
+    // to modify from two threads at once. Null pointers are never linked.
+    // There are no converting constructors: a base subobject may live at
+    // another address and would hash to another stripe than its ring.
+    template <typename T, typename D = default_delete<T>>
+    class concurrent_linked_ptr : private details::deleter_holder<D>
+    {
+        using deleter_base = details::deleter_holder<D>;
+
+    private:
+        mutable details::intrusive_mixin intrusive_node;
+        T* pointer;
+
+    public:
+        using element_type = T;
+        using deleter_type = D;
+
+// constructors / destructor
+        constexpr concurrent_linked_ptr() noexcept : deleter_base(), intrusive_node(), pointer(nullptr) {}
+
+        explicit concurrent_linked_ptr(T* pointer) noexcept : deleter_base(), intrusive_node(), pointer(pointer) {}
+
+        concurrent_linked_ptr(T* pointer, D deleter) noexcept
+            : deleter_base(std::move(deleter)), intrusive_node(), pointer(pointer) {}
+
+        concurrent_linked_ptr(concurrent_linked_ptr const& other)
+            : deleter_base(other.deleter()), intrusive_node(), pointer(other.pointer)
+        {
+            other.attach(*this);
+        }
+
+        concurrent_linked_ptr(concurrent_linked_ptr&& other) noexcept
+            : deleter_base(std::move(other.deleter())), intrusive_node(), pointer(nullptr)
+        {
+            take(other);
+        }
+
+        ~concurrent_linked_ptr()
+        {
+            destroy();
+        }
+
+// assign operators
+        concurrent_linked_ptr& operator=(concurrent_linked_ptr const& other)
+        {
+            concurrent_linked_ptr tmp(other);
+            swap(tmp);
+            return *this;
+        }
+
+        concurrent_linked_ptr& operator=(concurrent_linked_ptr&& other) noexcept
+        {
+            if (this != &other)
+            {
+                destroy();
+                deleter() = std::move(other.deleter());
+                take(other);
+            }
+            return *this;
+        }
+
+// common smart pointer interface
+        template <typename U = T, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+        void reset(U* new_pointer = nullptr)
+        {
+            destroy();
+            pointer = new_pointer;
+        }
+
+        void swap(concurrent_linked_ptr& other) noexcept
+        {
+            using std::swap;
+            {
+                details::ring_lock_pair_guard guard(pointer, other.pointer);
+                intrusive_node.swap(other.intrusive_node);
+            }
+            swap(pointer, other.pointer);
+            swap(deleter(), other.deleter());
+        }
+
+        T* get() const noexcept
+        {
+            return pointer;
+        }
+
+        D& get_deleter() noexcept
+        {
+            return deleter();
+        }
+
+        D const& get_deleter() const noexcept
+        {
+            return deleter();
+        }
+
+        bool unique() const noexcept
+        {
+            if (!pointer)
+                return false;
+            details::ring_lock_guard guard(pointer);
+            return intrusive_node.is_last();
+        }
+
+        std::size_t use_count() const noexcept
+        {
+            if (!pointer)
+                return 0;
+            details::ring_lock_guard guard(pointer);
+            return intrusive_node.count();
+        }
+
+        operator bool() const noexcept
+        {
+            return get();
+        }
+
+// pointer using interface
+        T& operator*() const
+        {
+            return *get();
+        }
+
+        T* operator->() const
+        {
+            return get();
+        }
+
+    private:
+        using deleter_base::deleter;
+
+        void attach(concurrent_linked_ptr const& copy) const noexcept
+        {
+            if (!pointer)
+                return;
+            details::ring_lock_guard guard(pointer);
+            intrusive_node.attach(&copy.intrusive_node);
+        }
+
+        void take(concurrent_linked_ptr& other) noexcept
+        {
+            if (other.pointer)
+            {
+                details::ring_lock_guard guard(other.pointer);
+                intrusive_node.replace(other.intrusive_node);
+            }
+            pointer = other.pointer;
+            other.pointer = nullptr;
+        }
+
+        void destroy()
+        {
+            if (!pointer)
+                return;
+            bool last;
+            {
+                details::ring_lock_guard guard(pointer);
+                last = intrusive_node.is_last();
+                intrusive_node.detach();
+            }
+            if (last)
+                deleter()(pointer);
+            pointer = nullptr;
+        }
+    };
+
+    template <typename T, typename D, typename U, typename E>
+    inline bool operator==(concurrent_linked_ptr<T, D> const& a, concurrent_linked_ptr<U, E> const& b) noexcept
+    {
+        return a.get() == b.get();
+    }
+
+    template <typename T, typename D, typename U, typename E>
+    inline bool operator!=(concurrent_linked_ptr<T, D> const& a, concurrent_linked_ptr<U, E> const& b) noexcept
+    {
+        return !(a == b);
+    }
+
+    template <typename T, typename D, typename U, typename E>
+    inline bool operator<(concurrent_linked_ptr<T, D> const& a, concurrent_linked_ptr<U, E> const& b) noexcept
+    {
+        return a.get() < b.get();
+    }
+
+    template <typename T, typename D>
+    void swap(concurrent_linked_ptr<T, D> &a, concurrent_linked_ptr<T, D> &b) noexcept
+    {
+        a.swap(b);
+    }
+}
+
+#endif
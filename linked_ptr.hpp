@@ -1,212 +1,2330 @@
 #ifndef LINKED_PTR_H
 #define LINKED_PTR_H
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
 namespace smart_ptr
 {
     namespace details
     {
-        class intrusive_mixin
+        class intrusive_mixin
+        {
+        public:
+            intrusive_mixin *l = nullptr;
+            intrusive_mixin *r = nullptr;
+
+            intrusive_mixin(intrusive_mixin *l, intrusive_mixin *r) : l(l), r(r) {}
+            intrusive_mixin() : intrusive_mixin(nullptr, nullptr) {}
+
+        public:
+            // A ring header links to itself on the left; owners never do.
+            bool is_header() const noexcept
+            {
+                return l == this;
+            }
+
+            bool is_last() const noexcept
+            {
+                return !r && (!l || l->is_header());
+            }
+
+            // An owner of a counted ring points at the header from both
+            // sides; linked owners never have equal non-null neighbours.
+            bool is_counted() const noexcept
+            {
+                return l == r && l;
+            }
+
+            static void prefetch(intrusive_mixin const* node) noexcept
+            {
+#if defined(__GNUC__)
+                __builtin_prefetch(node);
+#else
+                (void) node;
+#endif
+            }
+
+            // Walks both directions at once, so the two chains of cache
+            // misses overlap instead of running back to back. Stops early
+            // once `limit` owners are seen.
+            std::size_t count(std::size_t limit = static_cast<std::size_t>(-1)) const noexcept
+            {
+                std::size_t result = 1;
+                intrusive_mixin const* left = l;
+                intrusive_mixin const* right = r;
+                while ((left || right) && result < limit)
+                {
+                    if (left)
+                    {
+                        intrusive_mixin const* next = left->l;
+                        if (next == left)
+                        {
+                            left = nullptr;
+                        }
+                        else
+                        {
+                            ++result;
+                            left = next;
+                        }
+                    }
+                    if (right)
+                    {
+                        ++result;
+                        right = right->r;
+                    }
+                }
+                return result;
+            }
+
+            intrusive_mixin const* leftmost() const noexcept
+            {
+                intrusive_mixin const* node = this;
+                while (node->l && !node->l->is_header())
+                    node = node->l;
+                return node;
+            }
+
+            void attach(intrusive_mixin* copy)
+            {
+                copy->l = this;
+                copy->r = r;
+                if (r)
+                    r->l = copy;
+                r = copy;
+            }
+
+            void replace(intrusive_mixin& other)
+            {
+                l = other.l;
+                r = other.r;
+                if (l != r)
+                {
+                    if (l)
+                        l->r = this;
+                    if (r)
+                        r->l = this;
+                }
+                other.l = nullptr;
+                other.r = nullptr;
+            }
+
+            // Called on a node copied bitwise from old_begin + (this - new
+            // location) as part of the block [old_begin, old_end), which
+            // moved by `delta` bytes. Links into the block are translated;
+            // neighbours outside it are pointed at the new address. Owners
+            // of counted rings need nothing: their header keeps no links.
+            void relocated(std::uintptr_t old_begin, std::uintptr_t old_end, std::ptrdiff_t delta) noexcept
+            {
+                if (l == r)
+                    return;
+                auto moved = [=](intrusive_mixin* node) noexcept
+                {
+                    auto address = reinterpret_cast<std::uintptr_t>(node);
+                    return address >= old_begin && address < old_end;
+                };
+                auto translate = [=](intrusive_mixin* node) noexcept
+                {
+                    return reinterpret_cast<intrusive_mixin*>(reinterpret_cast<char*>(node) + delta);
+                };
+                if (l)
+                {
+                    if (moved(l))
+                        l = translate(l);
+                    else
+                        l->r = this;
+                }
+                if (r)
+                {
+                    if (moved(r))
+                        r = translate(r);
+                    else
+                        r->l = this;
+                }
+            }
+
+            // Links detach() writes in the neighbours.
+            std::size_t detach_writes() const noexcept
+            {
+                return l == r ? 0 : (l ? 1 : 0) + (r ? 1 : 0);
+            }
+
+            void detach()
+            {
+                if (l != r)
+                {
+                    if (l)
+                        l->r = r;
+                    if (r)
+                        r->l = l;
+                }
+                l = nullptr;
+                r = nullptr;
+            }
+
+            // Exchanges ring positions, which also covers two adjacent
+            // owners of the same ring.
+            void swap(intrusive_mixin &other)
+            {
+                intrusive_mixin tmp;
+                tmp.replace(*this);
+                replace(other);
+                other.replace(tmp);
+            }
+        };
+
+        class owner_iterator
+        {
+        private:
+            intrusive_mixin const* node = nullptr;
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = void const*;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void const* const*;
+            using reference = void const*;
+
+            owner_iterator() noexcept = default;
+            explicit owner_iterator(intrusive_mixin const* node) noexcept : node(node) {}
+
+            reference operator*() const noexcept
+            {
+                return node;
+            }
+
+            owner_iterator& operator++() noexcept
+            {
+                node = node->is_counted() ? nullptr : node->r;
+                if (node)
+                    intrusive_mixin::prefetch(node->r);
+                return *this;
+            }
+
+            owner_iterator operator++(int) noexcept
+            {
+                owner_iterator result = *this;
+                ++*this;
+                return result;
+            }
+
+            friend bool operator==(owner_iterator const& a, owner_iterator const& b) noexcept
+            {
+                return a.node == b.node;
+            }
+
+            friend bool operator!=(owner_iterator const& a, owner_iterator const& b) noexcept
+            {
+                return !(a == b);
+            }
+        };
+
+        // Owners of one object from the leftmost to the rightmost. Each
+        // owner is identified by an opaque address, the same one that
+        // linked_ptr::owner_id() reports. A counted ring does not know its
+        // owners, so only the owner the range was taken from is visited.
+        class owner_range
+        {
+        private:
+            owner_iterator first;
+
+        public:
+            explicit owner_range(intrusive_mixin const* leftmost) noexcept : first(leftmost) {}
+
+            owner_iterator begin() const noexcept
+            {
+                return first;
+            }
+
+            owner_iterator end() const noexcept
+            {
+                return owner_iterator();
+            }
+        };
+
+        // Optional leftmost member of a ring that owns the pointee instead
+        // of the owners themselves. Created by make_linked, where it shares
+        // one allocation with the object, or on demand when a ring is
+        // promoted to a counted one or gets its first weak observer. Owners
+        // of a counted ring are unlinked and only the header's owner count
+        // keeps track of them. The header outlives the object while weak
+        // observers remain.
+        class ring_header : public intrusive_mixin
+        {
+        public:
+            std::size_t owners = 0;
+            std::size_t weak = 0;
+            bool destroyed = false;
+
+            ring_header() noexcept : intrusive_mixin(this, nullptr) {}
+
+            ring_header(ring_header const&) = delete;
+            ring_header& operator=(ring_header const&) = delete;
+
+            // Called once the last owner is gone. The extra weak reference
+            // keeps the header alive while the object's destructor drops
+            // weak observers of its own.
+            void release() noexcept
+            {
+                begin_release();
+                finish_release();
+            }
+
+            // The two halves of release(), apart when destruction is
+            // deferred: weak observers see the object expired right away.
+            void begin_release() noexcept
+            {
+                ++weak;
+                destroyed = true;
+            }
+
+            void finish_release() noexcept
+            {
+                destroy_object();
+                drop_weak();
+            }
+
+            void add_weak() noexcept
+            {
+                ++weak;
+            }
+
+            void drop_weak() noexcept
+            {
+                if (--weak == 0 && destroyed)
+                    deallocate();
+            }
+
+            // Links a new owner right after the header, or counts it.
+            void join(intrusive_mixin* node) noexcept
+            {
+                if (owners)
+                    add_owner(node);
+                else
+                    attach(node);
+            }
+
+            std::size_t use_count() const noexcept
+            {
+                if (owners)
+                    return owners;
+                return r ? r->count() : 0;
+            }
+
+            void add_owner(intrusive_mixin* node) noexcept
+            {
+                ++owners;
+                node->l = this;
+                node->r = this;
+            }
+
+            void drop_owner() noexcept
+            {
+                if (--owners == 0)
+                    release();
+            }
+
+            // Unlinks every owner of the ring starting at `first` and counts
+            // them instead.
+            void promote(intrusive_mixin* first) noexcept
+            {
+                while (first)
+                {
+                    intrusive_mixin* next = first->r;
+                    add_owner(first);
+                    first = next;
+                }
+                r = nullptr;
+            }
+
+            // Turns a counted ring with one remaining owner back into a
+            // linked one.
+            void demote(intrusive_mixin* last) noexcept
+            {
+                owners = 0;
+                last->l = this;
+                last->r = nullptr;
+                r = last;
+            }
+
+        protected:
+            ~ring_header() = default;
+
+        private:
+            virtual void destroy_object() noexcept = 0;
+            virtual void deallocate() noexcept = 0;
+        };
+
+        struct for_overwrite_t {};
+
+        template <typename T>
+        class inplace_header final : public ring_header
+        {
+        private:
+            alignas(T) unsigned char storage[sizeof(T)];
+
+        public:
+            template <typename... Args>
+            explicit inplace_header(Args&&... args)
+            {
+                ::new (static_cast<void*>(storage)) T(std::forward<Args>(args)...);
+            }
+
+            explicit inplace_header(for_overwrite_t)
+            {
+                ::new (static_cast<void*>(storage)) T;
+            }
+
+            T* get() noexcept
+            {
+                return std::launder(reinterpret_cast<T*>(storage));
+            }
+
+        private:
+            void destroy_object() noexcept override
+            {
+                get()->~T();
+            }
+
+            void deallocate() noexcept override
+            {
+                delete this;
+            }
+        };
+
+        template <typename T, typename Alloc>
+        class allocated_header final : public ring_header
+        {
+        private:
+            using allocator_type = typename std::allocator_traits<Alloc>::template rebind_alloc<allocated_header>;
+            using allocator_traits = std::allocator_traits<allocator_type>;
+            using object_allocator_type = typename std::allocator_traits<Alloc>::template rebind_alloc<std::remove_cv_t<T>>;
+            using object_allocator_traits = std::allocator_traits<object_allocator_type>;
+
+            allocator_type allocator;
+            alignas(T) unsigned char storage[sizeof(T)];
+
+            template <typename... Args>
+            explicit allocated_header(allocator_type const& allocator, Args&&... args) : allocator(allocator)
+            {
+                object_allocator_type object_allocator(this->allocator);
+                object_allocator_traits::construct(object_allocator, get(), std::forward<Args>(args)...);
+            }
+
+        public:
+            template <typename... Args>
+            static allocated_header* create(Alloc const& alloc, Args&&... args)
+            {
+                allocator_type allocator(alloc);
+                allocated_header* header = allocator_traits::allocate(allocator, 1);
+                try
+                {
+                    ::new (static_cast<void*>(header)) allocated_header(allocator, std::forward<Args>(args)...);
+                }
+                catch (...)
+                {
+                    allocator_traits::deallocate(allocator, header, 1);
+                    throw;
+                }
+                return header;
+            }
+
+            std::remove_cv_t<T>* get() noexcept
+            {
+                return std::launder(reinterpret_cast<std::remove_cv_t<T>*>(storage));
+            }
+
+        private:
+            void destroy_object() noexcept override
+            {
+                object_allocator_type object_allocator(allocator);
+                object_allocator_traits::destroy(object_allocator, get());
+            }
+
+            void deallocate() noexcept override
+            {
+                allocator_type allocator(std::move(this->allocator));
+                this->~allocated_header();
+                allocator_traits::deallocate(allocator, this, 1);
+            }
+        };
+
+        // Header followed by the elements of an array in one allocation.
+        template <typename E>
+        class array_header final : public ring_header
+        {
+        private:
+            using element_type = std::remove_cv_t<E>;
+
+            std::size_t size;
+
+            explicit array_header(std::size_t size) noexcept : size(size) {}
+
+            static constexpr std::size_t alignment() noexcept
+            {
+                return alignof(array_header) > alignof(element_type) ? alignof(array_header) : alignof(element_type);
+            }
+
+            static constexpr std::size_t elements_offset() noexcept
+            {
+                return (sizeof(array_header) + alignof(element_type) - 1) / alignof(element_type) * alignof(element_type);
+            }
+
+            static void* allocate(std::size_t bytes)
+            {
+                if constexpr (alignment() > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+                    return ::operator new(bytes, std::align_val_t(alignment()));
+                else
+                    return ::operator new(bytes);
+            }
+
+            static void deallocate_memory(void* memory) noexcept
+            {
+                if constexpr (alignment() > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+                    ::operator delete(memory, std::align_val_t(alignment()));
+                else
+                    ::operator delete(memory);
+            }
+
+        public:
+            // `init` constructs one element in place; elements built before
+            // a throwing one are destroyed in reverse order.
+            template <typename Init>
+            static array_header* create(std::size_t size, Init init)
+            {
+                if (size > (static_cast<std::size_t>(-1) - elements_offset()) / sizeof(element_type))
+                    throw std::bad_array_new_length();
+                void* memory = allocate(elements_offset() + size * sizeof(element_type));
+                auto* header = ::new (memory) array_header(size);
+                element_type* elements = header->get();
+                std::size_t constructed = 0;
+                try
+                {
+                    for (; constructed < size; ++constructed)
+                        init(static_cast<void*>(elements + constructed));
+                }
+                catch (...)
+                {
+                    while (constructed)
+                        elements[--constructed].~element_type();
+                    header->~array_header();
+                    deallocate_memory(memory);
+                    throw;
+                }
+                return header;
+            }
+
+            element_type* get() noexcept
+            {
+                return std::launder(reinterpret_cast<element_type*>(reinterpret_cast<unsigned char*>(this) + elements_offset()));
+            }
+
+        private:
+            void destroy_object() noexcept override
+            {
+                element_type* elements = get();
+                for (std::size_t i = size; i != 0; --i)
+                    elements[i - 1].~element_type();
+            }
+
+            void deallocate() noexcept override
+            {
+                this->~array_header();
+                deallocate_memory(this);
+            }
+        };
+
+        template <typename T>
+        constexpr bool is_unbounded_array_v = std::is_array_v<T> && std::extent_v<T> == 0;
+
+        template <typename T>
+        constexpr bool is_bounded_array_v = std::is_array_v<T> && std::extent_v<T> != 0;
+
+        struct access;
+    }
+
+    template <typename T>
+    class weak_linked_ptr;
+
+    template <typename T>
+    class enable_linked_from_this;
+
+    namespace details
+    {
+        struct linked_from_this_tag {};
+
+        struct splice_tag {};
+
+        template <typename T>
+        constexpr bool is_linked_from_this_v = std::is_base_of_v<linked_from_this_tag, T>;
+
+        template <typename X, typename U, typename Owner>
+        void set_weak_this(enable_linked_from_this<X> const* base, U* raw, Owner const& owner);
+    }
+
+    using namespace details;
+
+    template <typename T>
+    struct default_delete
+    {
+        constexpr default_delete() noexcept = default;
+
+        template <typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+        default_delete(default_delete<U> const&) noexcept {}
+
+        void operator()(T* pointer) const noexcept
+        {
+            //enum {T_have_to_be_complete = sizeof(T)};
+            delete pointer;
+        }
+    };
+
+    template <typename T>
+    struct default_delete<T[]>
+    {
+        constexpr default_delete() noexcept = default;
+
+        template <typename U, typename = std::enable_if_t<std::is_convertible_v<U(*)[], T(*)[]>>>
+        default_delete(default_delete<U[]> const&) noexcept {}
+
+        void operator()(T* pointer) const noexcept
+        {
+            delete[] pointer;
+        }
+    };
+
+    template <typename T, std::size_t N>
+    struct default_delete<T[N]> : default_delete<T[]> {};
+
+    namespace details
+    {
+        // Whether a raw Y* may be owned by linked_ptr<T>. For arrays only
+        // qualification conversions are allowed, as for std::shared_ptr.
+        template <typename Y, typename T>
+        struct is_pointer_compatible : std::is_convertible<Y*, T*> {};
+
+        template <typename Y, typename T>
+        struct is_pointer_compatible<Y, T[]> : std::is_convertible<Y(*)[], T(*)[]> {};
+
+        template <typename Y, typename T, std::size_t N>
+        struct is_pointer_compatible<Y, T[N]> : std::is_convertible<Y(*)[N], T(*)[N]> {};
+
+        template <typename Y, typename T>
+        constexpr bool is_pointer_compatible_v = is_pointer_compatible<Y, T>::value;
+    }
+
+    namespace details
+    {
+        // Keeps stateless deleters out of the object layout.
+        template <typename D, bool = std::is_empty_v<D> && !std::is_final_v<D>>
+        class deleter_holder : private D
+        {
+        protected:
+            constexpr deleter_holder() noexcept(std::is_nothrow_default_constructible_v<D>) : D() {}
+
+            template <typename E>
+            explicit deleter_holder(E&& deleter) : D(std::forward<E>(deleter)) {}
+
+            D& deleter() noexcept
+            {
+                return *this;
+            }
+
+            D const& deleter() const noexcept
+            {
+                return *this;
+            }
+        };
+
+        template <typename D>
+        class deleter_holder<D, false>
+        {
+        private:
+            D stored_deleter;
+
+        protected:
+            constexpr deleter_holder() noexcept(std::is_nothrow_default_constructible_v<D>) : stored_deleter() {}
+
+            template <typename E>
+            explicit deleter_holder(E&& deleter) : stored_deleter(std::forward<E>(deleter)) {}
+
+            D& deleter() noexcept
+            {
+                return stored_deleter;
+            }
+
+            D const& deleter() const noexcept
+            {
+                return stored_deleter;
+            }
+        };
+
+        // Header created when a ring without one is promoted; owns the
+        // pointee through the deleter of the owner that promoted it.
+        template <typename T, typename D>
+        class pointer_header final : public ring_header, private deleter_holder<D>
+        {
+        private:
+            T* pointer;
+
+        public:
+            pointer_header(T* pointer, D const& deleter) : deleter_holder<D>(deleter), pointer(pointer) {}
+
+        private:
+            void destroy_object() noexcept override
+            {
+                this->deleter()(pointer);
+            }
+
+            void deallocate() noexcept override
+            {
+                delete this;
+            }
+        };
+    }
+
+    namespace details
+    {
+        struct deferred_entry
+        {
+            void (*destroy)(void*) noexcept;
+            void* object;
+        };
+
+        inline void destroy_entries(std::vector<deferred_entry>& entries) noexcept
+        {
+            for (deferred_entry const& e : entries)
+                e.destroy(e.object);
+            entries.clear();
+        }
+
+        // Where threads hand off objects that may be destroyed elsewhere,
+        // in batches of batch_size(); see reclaimer. submit() takes the
+        // entries out of `batch`.
+        class deferred_sink
+        {
+        public:
+            virtual std::size_t batch_size() const noexcept = 0;
+            virtual void submit(std::vector<deferred_entry>& batch) noexcept = 0;
+
+        protected:
+            ~deferred_sink() = default;
+        };
+
+        inline std::atomic<deferred_sink*>& installed_sink() noexcept
+        {
+            static std::atomic<deferred_sink*> sink{nullptr};
+            return sink;
+        }
+
+        // Objects whose last owner went away on this thread, waiting to be
+        // destroyed at a point of the thread's choosing. Destructors run
+        // by drain() may defer further objects; they are appended and
+        // drained in the same call if the limit allows. Objects nothing
+        // else refers to go to the installed sink instead, if any. Once
+        // the queue is destroyed at thread exit, objects released later,
+        // e.g. by thread_local or static owners, are destroyed right away.
+        class deferred_queue
+        {
+        private:
+            std::vector<deferred_entry> entries;
+            std::size_t head = 0;
+            std::vector<deferred_entry> outgoing;
+
+        public:
+            deferred_queue() = default;
+
+            deferred_queue(deferred_queue const&) = delete;
+            deferred_queue& operator=(deferred_queue const&) = delete;
+
+            // Objects still queued when the thread exits are destroyed then.
+            ~deferred_queue()
+            {
+                drain(static_cast<std::size_t>(-1));
+                closed() = true;
+                destroy_entries(outgoing);
+            }
+
+            // Set for good once this thread's queue is destroyed; being
+            // trivially destructible, it outlives the queue.
+            static bool& closed() noexcept
+            {
+                thread_local bool flag = false;
+                return flag;
+            }
+
+            // Destroys the object right away if the queue cannot grow or
+            // is gone. `portable` objects may be destroyed on any thread.
+            void push(void (*destroy)(void*) noexcept, void* object, bool portable) noexcept
+            {
+                if (closed())
+                {
+                    destroy(object);
+                    return;
+                }
+                deferred_sink* sink = portable ? installed_sink().load(std::memory_order_acquire) : nullptr;
+                try
+                {
+                    if (sink)
+                    {
+                        outgoing.push_back(deferred_entry{destroy, object});
+                        if (outgoing.size() >= sink->batch_size())
+                            sink->submit(outgoing);
+                    }
+                    else
+                    {
+                        entries.push_back(deferred_entry{destroy, object});
+                    }
+                }
+                catch (...)
+                {
+                    destroy(object);
+                }
+            }
+
+            // Submits a partial batch, or destroys it with no sink left.
+            void hand_off() noexcept
+            {
+                if (closed() || outgoing.empty())
+                    return;
+                if (deferred_sink* sink = installed_sink().load(std::memory_order_acquire))
+                    sink->submit(outgoing);
+                else
+                    destroy_entries(outgoing);
+            }
+
+            std::size_t drain(std::size_t limit) noexcept
+            {
+                if (closed())
+                    return 0;
+                std::size_t done = 0;
+                while (done < limit && head < entries.size())
+                {
+                    deferred_entry next = entries[head++];
+                    next.destroy(next.object);
+                    ++done;
+                }
+                if (head == entries.size())
+                {
+                    entries.clear();
+                    head = 0;
+                }
+                return done;
+            }
+
+            std::size_t size() const noexcept
+            {
+                if (closed())
+                    return 0;
+                return entries.size() - head;
+            }
+        };
+
+        inline deferred_queue& deferred() noexcept
+        {
+            thread_local deferred_queue queue;
+            return queue;
+        }
+    }
+
+    // Destroys up to `limit` objects deferred on this thread, oldest
+    // first, and returns how many were destroyed. Meant to be called at
+    // safe points, like the end of an event loop iteration. Also submits
+    // the thread's partial batch to the installed reclaimer.
+    inline std::size_t drain_deferred(std::size_t limit = static_cast<std::size_t>(-1)) noexcept
+    {
+        details::deferred().hand_off();
+        return details::deferred().drain(limit);
+    }
+
+    // Objects deferred on this thread and not destroyed yet, leaving out
+    // those waiting to be handed to a reclaimer.
+    inline std::size_t deferred_count() noexcept
+    {
+        return details::deferred().size();
+    }
+
+    namespace details
+    {
+        // Used for types whose traits leave pool_high_water_mark out.
+        std::size_t const default_pool_high_water_mark = 1024;
+    }
+
+    // Per-type tuning, meant to be specialized by users.
+    template <typename T>
+    struct linked_ptr_traits
+    {
+        // A ring that would grow past this many owners is promoted to an
+        // out-of-line owner count kept in its header, so copies and
+        // releases stop touching neighbouring owners. Lengths are checked
+        // on some copies only, so a ring may grow to about twice this
+        // before it is promoted. 0 never promotes.
+        static constexpr std::size_t promotion_threshold = 0;
+
+        // Whether a counted ring is linked again once a single owner is
+        // left and gets copied.
+        static constexpr bool demote = true;
+
+        // Whether owners of T count their ring operations; see
+        // linked_ptr_stats. May be left out of specializations.
+        static constexpr bool collect_stats = false;
+
+        // Whether the last owner hands the object to the queue of its
+        // thread instead of destroying it; see drain_deferred. May be left
+        // out of specializations.
+        static constexpr bool defer_destruction = false;
+
+        // Blocks a thread keeps for reuse by linked_pool<T> at most. May be
+        // left out of specializations.
+        static constexpr std::size_t pool_high_water_mark = details::default_pool_high_water_mark;
+    };
+
+    // Totals of the ring operations of one pointee type, over all threads
+    // and the whole run of the process; they are never reset.
+    struct ring_stats
+    {
+        static constexpr std::size_t histogram_size = 32;
+
+        // Rings started by taking ownership of an object.
+        std::size_t constructions = 0;
+        std::size_t attaches = 0;
+        // Owners that left a ring other owners kept alive.
+        std::size_t detaches = 0;
+        // Links written in the neighbours that released owners left
+        // behind: up to two per owner, or per run of ring neighbours that
+        // reset_range releases together.
+        std::size_t unlink_writes = 0;
+        std::size_t swaps = 0;
+        std::size_t deletes = 0;
+        // Ring lengths after attaches: every one to a counted ring, whose
+        // header knows it, and a sample of the others, since those are
+        // only known by walking the ring. Both can under-report uncounted
+        // rings: their longest length may never be sampled. Bucket i
+        // counts lengths in [2^i, 2^(i + 1)).
+        std::size_t peak_ring_length = 0;
+        std::size_t ring_length_histogram[histogram_size] = {};
+    };
+
+    namespace details
+    {
+        template <typename Traits, typename = void>
+        struct collects_stats : std::false_type {};
+
+        template <typename Traits>
+        struct collects_stats<Traits, std::void_t<decltype(Traits::collect_stats)>> : std::bool_constant<Traits::collect_stats> {};
+
+        template <typename Traits, typename = void>
+        struct defers_destruction : std::false_type {};
+
+        template <typename Traits>
+        struct defers_destruction<Traits, std::void_t<decltype(Traits::defer_destruction)>> : std::bool_constant<Traits::defer_destruction> {};
+
+        // Counters of one thread. Only the owning thread writes them, so
+        // relaxed loads and stores suffice and readers never block it.
+        class thread_stats
+        {
+        private:
+            using counter = std::atomic<std::size_t>;
+
+            counter constructions{0};
+            counter attaches{0};
+            counter detaches{0};
+            counter unlink_writes{0};
+            counter swaps{0};
+            counter deletes{0};
+            counter peak_ring_length{0};
+            counter ring_length_histogram[ring_stats::histogram_size] = {};
+            // Attaches left before the next walk; read by this thread only.
+            std::size_t unsampled = 0;
+
+            static void add(counter& c, std::size_t n) noexcept
+            {
+                c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+            }
+
+            static void increment(counter& c) noexcept
+            {
+                add(c, 1);
+            }
+
+        public:
+            thread_stats* prev = nullptr;
+            thread_stats* next = nullptr;
+
+            void construction() noexcept
+            {
+                increment(constructions);
+            }
+
+            void attach() noexcept
+            {
+                increment(attaches);
+            }
+
+            // A walk over n owners is followed by n attaches without one,
+            // so sampling costs O(1) per attach on average.
+            bool sample_due() noexcept
+            {
+                if (unsampled == 0)
+                    return true;
+                --unsampled;
+                return false;
+            }
+
+            void sampled_ring_length(std::size_t ring_length) noexcept
+            {
+                unsampled = ring_length;
+                record_ring_length(ring_length);
+            }
+
+            void record_ring_length(std::size_t ring_length) noexcept
+            {
+                if (ring_length > peak_ring_length.load(std::memory_order_relaxed))
+                    peak_ring_length.store(ring_length, std::memory_order_relaxed);
+                std::size_t bucket = 0;
+                while (ring_length >>= 1)
+                    ++bucket;
+                increment(ring_length_histogram[bucket < ring_stats::histogram_size ? bucket : ring_stats::histogram_size - 1]);
+            }
+
+            void detach() noexcept
+            {
+                increment(detaches);
+            }
+
+            void unlink(std::size_t writes) noexcept
+            {
+                add(unlink_writes, writes);
+            }
+
+            void swap() noexcept
+            {
+                increment(swaps);
+            }
+
+            void deletion() noexcept
+            {
+                increment(deletes);
+            }
+
+            void add_to(ring_stats& total) const noexcept
+            {
+                total.constructions += constructions.load(std::memory_order_relaxed);
+                total.attaches += attaches.load(std::memory_order_relaxed);
+                total.detaches += detaches.load(std::memory_order_relaxed);
+                total.unlink_writes += unlink_writes.load(std::memory_order_relaxed);
+                total.swaps += swaps.load(std::memory_order_relaxed);
+                total.deletes += deletes.load(std::memory_order_relaxed);
+                std::size_t peak = peak_ring_length.load(std::memory_order_relaxed);
+                if (peak > total.peak_ring_length)
+                    total.peak_ring_length = peak;
+                for (std::size_t i = 0; i < ring_stats::histogram_size; ++i)
+                    total.ring_length_histogram[i] += ring_length_histogram[i].load(std::memory_order_relaxed);
+            }
+        };
+
+        // Threads that count operations of one type; the counters of
+        // finished threads are folded into `retired`.
+        class stats_registry
+        {
+        private:
+            std::mutex mutex;
+            ring_stats retired;
+            thread_stats* threads = nullptr;
+
+        public:
+            void add(thread_stats* stats)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stats->next = threads;
+                if (threads)
+                    threads->prev = stats;
+                threads = stats;
+            }
+
+            void remove(thread_stats* stats)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stats->add_to(retired);
+                if (stats->prev)
+                    stats->prev->next = stats->next;
+                else
+                    threads = stats->next;
+                if (stats->next)
+                    stats->next->prev = stats->prev;
+            }
+
+            ring_stats total()
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ring_stats result = retired;
+                for (thread_stats* stats = threads; stats; stats = stats->next)
+                    stats->add_to(result);
+                return result;
+            }
+        };
+
+        template <typename T>
+        stats_registry& stats_registry_for()
+        {
+            static stats_registry registry;
+            return registry;
+        }
+
+        template <typename T>
+        class registered_thread_stats : public thread_stats
+        {
+        public:
+            registered_thread_stats()
+            {
+                stats_registry_for<T>().add(this);
+            }
+
+            registered_thread_stats(registered_thread_stats const&) = delete;
+            registered_thread_stats& operator=(registered_thread_stats const&) = delete;
+
+            ~registered_thread_stats()
+            {
+                stats_registry_for<T>().remove(this);
+            }
+        };
+
+        template <typename T>
+        thread_stats& thread_stats_for()
+        {
+            thread_local registered_thread_stats<T> stats;
+            return stats;
+        }
+    }
+
+    // Aggregates the counters of every thread that used linked_ptr<T>,
+    // for types whose linked_ptr_traits set collect_stats.
+    template <typename T>
+    ring_stats linked_ptr_stats()
+    {
+        return details::stats_registry_for<std::remove_cv_t<T>>().total();
+    }
+
+    template <typename T, typename D = default_delete<T>>
+    class linked_ptr : private details::deleter_holder<D>
+    {
+        template <typename U, typename E>
+        friend class linked_ptr;
+
+        friend struct details::access;
+
+        using deleter_base = details::deleter_holder<D>;
+
+    public:
+        using element_type = std::remove_extent_t<T>;
+        using deleter_type = D;
+
+    private:
+        mutable intrusive_mixin intrusive_node;
+        element_type* pointer;
+
+    public:
+// constructors / destructor
+        constexpr linked_ptr() noexcept : deleter_base(), intrusive_node(), pointer(nullptr) {}
+
+        explicit linked_ptr(element_type* pointer) noexcept(!is_linked_from_this_v<T>)
+            : deleter_base(), intrusive_node(), pointer(pointer)
+        {
+            record_construction();
+            enable_linked_from_this_hook(pointer);
+        }
+
+        linked_ptr(element_type* pointer, D deleter) noexcept(!is_linked_from_this_v<T>)
+            : deleter_base(std::move(deleter)), intrusive_node(), pointer(pointer)
+        {
+            record_construction();
+            enable_linked_from_this_hook(pointer);
+        }
+
+        linked_ptr(linked_ptr const& other) : deleter_base(other.deleter()), intrusive_node(), pointer(other.get())
+        {
+            other.attach(*this);
+        }
+
+        linked_ptr(linked_ptr&& other) noexcept : deleter_base(std::move(other.deleter())), intrusive_node(), pointer(other.pointer)
+        {
+            other.pointer = nullptr;
+            intrusive_node.replace(other.intrusive_node);
+        }
+
+        template <typename U, typename = std::enable_if_t<is_pointer_compatible_v<U, T>>>
+        explicit linked_ptr(U* pointer) : deleter_base(), intrusive_node(), pointer(pointer)
+        {
+            record_construction();
+            enable_linked_from_this_hook(pointer);
+        }
+
+        template <typename U, typename E, typename = std::enable_if_t<std::is_convertible_v<U*, T*> &&
+                                                                      std::is_constructible_v<D, E const&>>>
+        linked_ptr(linked_ptr<U, E> const& other) : deleter_base(other.deleter()), intrusive_node(), pointer(other.get())
+        {
+            other.attach(*this);
+        }
+
+        template <typename U, typename E, typename = std::enable_if_t<std::is_convertible_v<U*, T*> &&
+                                                                      std::is_constructible_v<D, E&&>>>
+        linked_ptr(linked_ptr<U, E>&& other) noexcept : deleter_base(std::move(other.deleter())), intrusive_node(), pointer(other.pointer)
+        {
+            other.pointer = nullptr;
+            intrusive_node.replace(other.intrusive_node);
+        }
+
+        // Aliasing constructors: the result shares ownership of `owner`'s
+        // object but points at `alias`, typically a member or an element
+        // of it. Ownership moves to the ring header, which is linked in on
+        // the first alias of a ring without one. Finding the header walks
+        // from `owner` to the start of the ring, unless `owner` is the
+        // ring's first owner or the ring is counted. Aliasing an empty
+        // owner yields an empty pointer.
+        template <typename U, typename E>
+        linked_ptr(linked_ptr<U, E> const& owner, element_type* alias) : deleter_base(), intrusive_node(), pointer(nullptr)
+        {
+            if (!owner.get())
+                return;
+            owner.make_header();
+            pointer = alias;
+            owner.attach(*this);
+        }
+
+        template <typename U, typename E>
+        linked_ptr(linked_ptr<U, E>&& owner, element_type* alias) : deleter_base(), intrusive_node(), pointer(nullptr)
+        {
+            if (!owner.get())
+                return;
+            owner.make_header();
+            pointer = alias;
+            owner.pointer = nullptr;
+            intrusive_node.replace(owner.intrusive_node);
+        }
+
+        ~linked_ptr()
+        {
+            destroy();
+        }
+
+// assign operators
+        linked_ptr& operator=(linked_ptr const& other) noexcept
+        {
+            auto tmp(other);
+            swap(tmp);
+            return *this;
+        }
+
+        linked_ptr& operator=(linked_ptr&& other) noexcept
+        {
+            if (this != &other)
+            {
+                destroy();
+                deleter() = std::move(other.deleter());
+                pointer = other.pointer;
+                other.pointer = nullptr;
+                intrusive_node.replace(other.intrusive_node);
+            }
+            return *this;
+        }
+
+        template <typename U, typename E, typename = std::enable_if_t<std::is_convertible_v<U*, T*> &&
+                                                                      std::is_constructible_v<D, E const&>>>
+        linked_ptr& operator=(linked_ptr<U, E> const& other)
+        {
+            linked_ptr tmp(other);
+            swap(tmp);
+            return *this;
+        }
+
+        template <typename U, typename E, typename = std::enable_if_t<std::is_convertible_v<U*, T*> &&
+                                                                      std::is_constructible_v<D, E&&>>>
+        linked_ptr& operator=(linked_ptr<U, E>&& other) noexcept
+        {
+            destroy();
+            deleter() = D(std::move(other.deleter()));
+            pointer = other.pointer;
+            other.pointer = nullptr;
+            intrusive_node.replace(other.intrusive_node);
+            return *this;
+        }
+
+// common smart pointer interface
+        template <typename U = element_type, typename = std::enable_if_t<is_pointer_compatible_v<U, T>>>
+        void reset(U* new_pointer = nullptr)
+        {
+            destroy();
+            pointer = new_pointer;
+            record_construction();
+            enable_linked_from_this_hook(new_pointer);
+        }
+
+        template <typename U, typename = std::enable_if_t<is_pointer_compatible_v<U, T>>>
+        void reset(U* new_pointer, D new_deleter)
+        {
+            destroy();
+            deleter() = std::move(new_deleter);
+            pointer = new_pointer;
+            record_construction();
+            enable_linked_from_this_hook(new_pointer);
+        }
+
+        void swap(linked_ptr& other) noexcept
+        {
+            using std::swap;
+            intrusive_node.swap(other.intrusive_node);
+            swap(pointer, other.pointer);
+            swap(deleter(), other.deleter());
+            if constexpr (collect_stats)
+                stats().swap();
+        }
+
+        element_type* get() const noexcept
+        {
+            return pointer;
+        }
+
+        D& get_deleter() noexcept
+        {
+            return deleter();
+        }
+
+        D const& get_deleter() const noexcept
+        {
+            return deleter();
+        }
+
+        bool unique() const noexcept
+        {
+            if (intrusive_node.is_counted())
+                return header()->owners == 1 && pointer;
+            return intrusive_node.is_last() && pointer;
+        }
+
+        // Number of owners of the pointee, found by walking the ring, or
+        // read from the header of a counted ring.
+        std::size_t use_count() const noexcept
+        {
+            if (!pointer)
+                return 0;
+            if (intrusive_node.is_counted())
+                return header()->owners;
+            return intrusive_node.count();
+        }
+
+        void const* owner_id() const noexcept
+        {
+            return &intrusive_node;
+        }
+
+        details::owner_range owners() const noexcept
+        {
+            return details::owner_range(intrusive_node.leftmost());
+        }
+
+        // Calls f(owner_id) for every owner, prefetching the next owner
+        // while f runs.
+        template <typename F>
+        void for_each_owner(F&& f) const
+        {
+            intrusive_mixin const* node = intrusive_node.leftmost();
+            while (node)
+            {
+                intrusive_mixin const* next = node->is_counted() ? nullptr : node->r;
+                if (next)
+                    intrusive_mixin::prefetch(next);
+                f(static_cast<void const*>(node));
+                node = next;
+            }
+        }
+
+        operator bool() const noexcept
+        {
+            return get();
+        }
+
+// pointer using interface
+        element_type& operator*() const
+        {
+            return *get();
+        }
+
+        element_type* operator->() const
+        {
+            return get();
+        }
+
+        template <typename U = T, typename = std::enable_if_t<std::is_array_v<U>>>
+        element_type& operator[](std::ptrdiff_t index) const
+        {
+            return get()[index];
+        }
+
+    private:
+        using deleter_base::deleter;
+
+        // The ring already has a header, so the hook cannot throw.
+        linked_ptr(ring_header* header, element_type* pointer) noexcept : deleter_base(), intrusive_node(), pointer(pointer)
+        {
+            header->join(&intrusive_node);
+            if constexpr (collect_stats)
+            {
+                bool alone = header->owners ? header->owners == 1 : !intrusive_node.r;
+                if (alone)
+                    stats().construction();
+                else
+                    record_attach();
+            }
+            enable_linked_from_this_hook(pointer);
+        }
+
+        // Cast results that join `source`'s ring, or take over its slot,
+        // with a default deleter standing in for its own; see access::cast.
+        template <typename U, typename E>
+        linked_ptr(splice_tag, linked_ptr<U, E> const& source, element_type* pointer) noexcept
+            : deleter_base(), intrusive_node(), pointer(pointer)
+        {
+            source.attach(*this);
+        }
+
+        template <typename U, typename E>
+        linked_ptr(splice_tag, linked_ptr<U, E>&& source, element_type* pointer) noexcept
+            : deleter_base(), intrusive_node(), pointer(pointer)
+        {
+            source.pointer = nullptr;
+            intrusive_node.replace(source.intrusive_node);
+        }
+
+        // Points the object's enable_linked_from_this base at this ring,
+        // unless it already belongs to one. Like std::shared_ptr, deletes
+        // the object if the ring header cannot be allocated.
+        template <typename U>
+        void enable_linked_from_this_hook(U* raw)
+        {
+            if constexpr (!std::is_array_v<T> && is_linked_from_this_v<U>)
+            {
+                if (!raw)
+                    return;
+                try
+                {
+                    details::set_weak_this(raw, raw, *this);
+                }
+                catch (...)
+                {
+                    destroy();
+                    throw;
+                }
+            }
+        }
+
+        using traits = linked_ptr_traits<std::remove_cv_t<T>>;
+
+        static constexpr bool collect_stats = details::collects_stats<traits>::value;
+        static constexpr bool defer_destruction = details::defers_destruction<traits>::value;
+
+        static details::thread_stats& stats() noexcept
+        {
+            return details::thread_stats_for<std::remove_cv_t<T>>();
+        }
+
+        void record_construction() const noexcept
+        {
+            if constexpr (collect_stats)
+            {
+                if (pointer)
+                    stats().construction();
+            }
+        }
+
+        ring_header* header() const noexcept
+        {
+            return static_cast<ring_header*>(intrusive_node.l);
+        }
+
+        template <typename U, typename E>
+        void attach(linked_ptr<U, E> const& copy) const noexcept
+        {
+            link(copy);
+            if constexpr (collect_stats)
+            {
+                if (pointer)
+                    record_attach();
+            }
+        }
+
+        void record_attach() const noexcept
+        {
+            details::thread_stats& counters = stats();
+            counters.attach();
+            if (intrusive_node.is_counted())
+                counters.record_ring_length(header()->owners);
+            else if (counters.sample_due())
+                counters.sampled_ring_length(intrusive_node.count());
+        }
+
+        template <typename U, typename E>
+        void link(linked_ptr<U, E> const& copy) const noexcept
+        {
+            if (intrusive_node.is_counted())
+            {
+                ring_header* counted = header();
+                if (!traits::demote || counted->owners != 1)
+                {
+                    counted->add_owner(&copy.intrusive_node);
+                    return;
+                }
+                counted->demote(&intrusive_node);
+            }
+            else if constexpr (traits::promotion_threshold != 0)
+            {
+                if (pointer && promotion_due())
+                {
+                    if (ring_header* counted = promote())
+                    {
+                        counted->add_owner(&copy.intrusive_node);
+                        return;
+                    }
+                }
+            }
+            intrusive_node.attach(&copy.intrusive_node);
+        }
+
+        // Walks the ring on some copies only: a walk that finds fewer than
+        // threshold owners is followed by threshold copies on this thread
+        // without one. Walking then costs less than one owner per copy on
+        // average, and a ring copied on one thread is promoted before it
+        // doubles the threshold.
+        bool promotion_due() const noexcept
+        {
+            thread_local std::size_t unchecked = 0;
+            if (unchecked != 0)
+            {
+                --unchecked;
+                return false;
+            }
+            std::size_t const threshold = traits::promotion_threshold;
+            std::size_t n = intrusive_node.count(threshold);
+            if (n >= threshold)
+                return true;
+            unchecked = threshold;
+            return false;
+        }
+
+        // Returns nullptr if a header is needed and cannot be allocated,
+        // in which case the ring simply stays linked.
+        ring_header* promote() const noexcept
+        {
+            auto* first = const_cast<intrusive_mixin*>(intrusive_node.leftmost());
+            ring_header* counted;
+            if (first->l)
+            {
+                counted = static_cast<ring_header*>(first->l);
+            }
+            else
+            {
+                counted = new (std::nothrow) details::pointer_header<element_type, D>(pointer, deleter());
+                if (!counted)
+                    return nullptr;
+            }
+            counted->promote(first);
+            return counted;
+        }
+
+        // Finds the ring's header, creating one that takes over ownership
+        // if the ring has none. Constant for owners of a counted ring and
+        // for the owner right after the header; otherwise it walks to the
+        // start of the ring, linear in the owners left of this one.
+        ring_header* make_header() const
+        {
+            if (intrusive_node.is_counted())
+                return header();
+            if (intrusive_node.l && intrusive_node.l->is_header())
+                return header();
+            auto* first = const_cast<intrusive_mixin*>(intrusive_node.leftmost());
+            if (first->l)
+                return static_cast<ring_header*>(first->l);
+            auto* created = new details::pointer_header<element_type, D>(pointer, deleter());
+            created->r = first;
+            first->l = created;
+            return created;
+        }
+
+        void detach() const noexcept
+        {
+            intrusive_node.detach();
+        }
+
+        static void finish_release(void* header) noexcept
+        {
+            static_cast<ring_header*>(header)->finish_release();
+        }
+
+        static void release_header(void* header) noexcept
+        {
+            static_cast<ring_header*>(header)->release();
+        }
+
+        static void delete_object(void* object) noexcept
+        {
+            D()(static_cast<element_type*>(object));
+        }
+
+        void release(ring_header* owner) noexcept
+        {
+            if constexpr (defer_destruction)
+            {
+                owner->begin_release();
+                // Weak observers would touch the header from this thread.
+                bool observed = owner->weak != 1;
+                details::deferred().push(&finish_release, owner, !observed);
+            }
+            else
+            {
+                owner->release();
+            }
+        }
+
+        // A stateless deleter is recreated when the queue is drained;
+        // any other one moves into a header that is released instead.
+        void delete_pointer()
+        {
+            if constexpr (defer_destruction)
+            {
+                auto* object = const_cast<std::remove_cv_t<element_type>*>(pointer);
+                if constexpr (std::is_empty_v<D> && std::is_default_constructible_v<D>)
+                {
+                    details::deferred().push(&delete_object, object, true);
+                    return;
+                }
+                else if (auto* owner = new (std::nothrow) details::pointer_header<element_type, D>(pointer, deleter()))
+                {
+                    details::deferred().push(&release_header, static_cast<ring_header*>(owner), true);
+                    return;
+                }
+                (void) object;
+            }
+            deleter()(pointer);
+        }
+
+        void destroy()
+        {
+            if constexpr (collect_stats)
+                stats().unlink(intrusive_node.detach_writes());
+            if (intrusive_node.is_last())
+            {
+                ring_header* owner = header();
+                intrusive_node.detach();
+                if constexpr (collect_stats)
+                {
+                    if (owner || pointer)
+                        stats().deletion();
+                }
+                if (owner)
+                    release(owner);
+                else if (pointer)
+                    delete_pointer();
+            }
+            else if (intrusive_node.is_counted())
+            {
+                ring_header* counted = header();
+                intrusive_node.detach();
+                if constexpr (collect_stats)
+                {
+                    if (counted->owners == 1)
+                        stats().deletion();
+                    else
+                        stats().detach();
+                }
+                if (--counted->owners == 0)
+                    release(counted);
+            }
+            else
+            {
+                intrusive_node.detach();
+                if constexpr (collect_stats)
+                {
+                    if (pointer)
+                        stats().detach();
+                }
+            }
+            pointer = nullptr;
+        }
+    };
+
+
+    namespace details
+    {
+        // Whether default_delete<T> may stand in for the source's deleter
+        // when the cast owner turns out to be the last one of its ring.
+        template <typename T, typename U, typename E>
+        constexpr bool splices_on_cast_v = std::is_same_v<E, default_delete<U>> &&
+                                           (std::is_same_v<std::remove_cv_t<T>, std::remove_cv_t<U>> ||
+                                            std::is_base_of_v<std::remove_cv_t<U>, std::remove_cv_t<T>> ||
+                                            (std::is_base_of_v<std::remove_cv_t<T>, std::remove_cv_t<U>> &&
+                                             std::has_virtual_destructor_v<std::remove_cv_t<T>>));
+
+        struct access
         {
-        public:
-            volatile intrusive_mixin *l = nullptr;
-            volatile intrusive_mixin *r = nullptr;
+            template <typename T>
+            static linked_ptr<T> adopt(ring_header* header, std::remove_extent_t<T>* pointer) noexcept
+            {
+                return linked_ptr<T>(header, pointer);
+            }
 
-            intrusive_mixin(intrusive_mixin *l, intrusive_mixin *r) : l(l), r(r) {}
-            intrusive_mixin() : intrusive_mixin(nullptr, nullptr) {}
+            template <typename T, typename D>
+            static ring_header* make_header(linked_ptr<T, D> const& owner)
+            {
+                return owner.get() ? owner.make_header() : nullptr;
+            }
 
-        public:
-            void attach(volatile intrusive_mixin* copy) volatile
+            template <typename T>
+            static weak_linked_ptr<T> make_weak(ring_header* header, std::remove_extent_t<T>* pointer) noexcept
             {
-                copy->l = this;
-                copy->r = r;
-                if (r)
-                    r->l = copy;
-                r = copy;
+                return weak_linked_ptr<T>(header, pointer);
             }
 
-            void detach() volatile
+            // Owners produced by the casts below. When the result may delete
+            // the object itself, it joins the source's ring directly, and
+            // the rvalue form takes over the source's slot; otherwise the
+            // ring's header takes over ownership, as for aliasing.
+            template <typename T, typename U, typename E>
+            static linked_ptr<T> cast(linked_ptr<U, E> const& source, std::remove_extent_t<T>* pointer)
             {
-                if (l)
-                    l->r = r;
-                if (r)
-                    r->l = l;
-                l = nullptr;
-                r = nullptr;
+                if (!pointer)
+                    return linked_ptr<T>();
+                if constexpr (splices_on_cast_v<T, U, E>)
+                    return linked_ptr<T>(splice_tag(), source, pointer);
+                else
+                    return linked_ptr<T>(source, pointer);
+            }
+
+            template <typename T, typename U, typename E>
+            static linked_ptr<T> cast(linked_ptr<U, E>&& source, std::remove_extent_t<T>* pointer)
+            {
+                if (!pointer)
+                    return linked_ptr<T>();
+                if constexpr (splices_on_cast_v<T, U, E>)
+                    return linked_ptr<T>(splice_tag(), std::move(source), pointer);
+                else
+                    return linked_ptr<T>(std::move(source), pointer);
+            }
+
+            // Moves the owners [first, first + n) to `dest`; the ranges may
+            // overlap and `dest` is raw storage afterwards at the source.
+            // Owners are copied bitwise and their neighbours patched once,
+            // instead of a move construction and a destruction per owner.
+            template <typename T, typename D>
+            static void relocate(linked_ptr<T, D>* first, std::size_t n, linked_ptr<T, D>* dest) noexcept
+            {
+                if (n == 0 || first == dest)
+                    return;
+                if constexpr (std::is_trivially_copyable_v<D>)
+                {
+                    auto old_begin = reinterpret_cast<std::uintptr_t>(first);
+                    auto old_end = old_begin + n * sizeof(linked_ptr<T, D>);
+                    std::ptrdiff_t delta = reinterpret_cast<char*>(dest) - reinterpret_cast<char*>(first);
+                    std::memmove(static_cast<void*>(dest), static_cast<void const*>(first), n * sizeof(linked_ptr<T, D>));
+                    for (std::size_t i = 0; i < n; ++i)
+                        dest[i].intrusive_node.relocated(old_begin, old_end, delta);
+                }
+                else if (dest < first)
+                {
+                    for (std::size_t i = 0; i < n; ++i)
+                    {
+                        ::new (static_cast<void*>(dest + i)) linked_ptr<T, D>(std::move(first[i]));
+                        first[i].~linked_ptr();
+                    }
+                }
+                else
+                {
+                    for (std::size_t i = n; i != 0; --i)
+                    {
+                        ::new (static_cast<void*>(dest + i - 1)) linked_ptr<T, D>(std::move(first[i - 1]));
+                        first[i - 1].~linked_ptr();
+                    }
+                }
             }
 
-            void swap(volatile intrusive_mixin &other) volatile
+            // Reorders [first, first + n) so that the owner at source[i]
+            // ends up at i. Owners are gathered bitwise into `buffer`, which
+            // holds n raw elements, their links translated through the
+            // inverse permutation `target`, and the block copied back.
+            template <typename T, typename D>
+            static void permute(linked_ptr<T, D>* first, std::size_t n, std::size_t const* source,
+                                std::size_t const* target, linked_ptr<T, D>* buffer) noexcept
             {
-                volatile intrusive_mixin* attach_target_a = (l ? l : r);
-                volatile intrusive_mixin* attach_target_b = (other.l ? other.l : other.r);
-                detach();
-                other.detach();
-                if (attach_target_a)
-                    attach_target_a->attach(&other);
-                if (attach_target_b)
-                    attach_target_b->attach(this);
+                static_assert(std::is_trivially_copyable_v<D>);
+                auto old_begin = reinterpret_cast<std::uintptr_t>(first);
+                auto old_end = old_begin + n * sizeof(linked_ptr<T, D>);
+                auto final_node = [first, target, old_begin](intrusive_mixin* node) noexcept
+                {
+                    auto index = (reinterpret_cast<std::uintptr_t>(node) - old_begin) / sizeof(linked_ptr<T, D>);
+                    return &first[target[index]].intrusive_node;
+                };
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    std::memcpy(static_cast<void*>(buffer + i), static_cast<void const*>(first + source[i]), sizeof(linked_ptr<T, D>));
+                    intrusive_mixin& node = buffer[i].intrusive_node;
+                    if (node.l == node.r)
+                        continue;
+                    intrusive_mixin* self = &first[i].intrusive_node;
+                    if (node.l)
+                    {
+                        auto address = reinterpret_cast<std::uintptr_t>(node.l);
+                        if (address >= old_begin && address < old_end)
+                            node.l = final_node(node.l);
+                        else
+                            node.l->r = self;
+                    }
+                    if (node.r)
+                    {
+                        auto address = reinterpret_cast<std::uintptr_t>(node.r);
+                        if (address >= old_begin && address < old_end)
+                            node.r = final_node(node.r);
+                        else
+                            node.r->l = self;
+                    }
+                }
+                std::memcpy(static_cast<void*>(first), static_cast<void const*>(buffer), n * sizeof(linked_ptr<T, D>));
+            }
+
+            // Releases every owner of [first, last), leaving them empty, and
+            // with End destroys them in the same pass. Consecutive owners
+            // that are also ring neighbours, as left by copying owners next
+            // to each other or by sorting, are found by reading the range in
+            // order. If other owners keep their ring alive, such a run is
+            // spliced out with at most two link writes in its neighbours,
+            // where releasing the owners one by one writes up to two each.
+            template <bool End, typename T, typename D>
+            static void reset_range(linked_ptr<T, D>* first, linked_ptr<T, D>* last) noexcept
+            {
+                while (first != last)
+                {
+                    intrusive_mixin* leftmost = &first->intrusive_node;
+                    linked_ptr<T, D>* end = first + 1;
+                    // The run grows to the right in the ring if the next
+                    // owner follows this one, and to the left if it
+                    // precedes it. Owners of counted rings are never linked
+                    // to each other.
+                    bool rightwards = false;
+                    if (leftmost->l != leftmost->r && end != last)
+                    {
+                        rightwards = end->intrusive_node.l == leftmost;
+                        bool leftwards = !rightwards && end->intrusive_node.r == leftmost;
+                        while (end != last && ((rightwards && end->intrusive_node.l == &end[-1].intrusive_node) ||
+                                               (leftwards && end->intrusive_node.r == &end[-1].intrusive_node)))
+                            ++end;
+                    }
+                    linked_ptr<T, D>* kept = end - 1;
+                    if (kept != first)
+                    {
+                        intrusive_mixin* before = rightwards ? first->intrusive_node.l : kept->intrusive_node.l;
+                        intrusive_mixin* after = rightwards ? kept->intrusive_node.r : first->intrusive_node.r;
+                        bool whole_ring = !after && (!before || before->is_header());
+                        if (whole_ring)
+                        {
+                            // The last owner releases the object, and its
+                            // detach unlinks the header.
+                            kept->intrusive_node.l = before;
+                            kept->intrusive_node.r = nullptr;
+                        }
+                        else
+                        {
+                            if (before)
+                                before->r = after;
+                            if (after)
+                                after->l = before;
+                            if constexpr (linked_ptr<T, D>::collect_stats)
+                                linked_ptr<T, D>::stats().unlink((before ? 1 : 0) + (after ? 1 : 0));
+                            kept = end;
+                        }
+                        for (auto* owner = first; owner != kept; ++owner)
+                        {
+                            if constexpr (linked_ptr<T, D>::collect_stats)
+                            {
+                                if (owner->pointer)
+                                    linked_ptr<T, D>::stats().detach();
+                            }
+                            owner->pointer = nullptr;
+                            owner->intrusive_node.l = nullptr;
+                            owner->intrusive_node.r = nullptr;
+                            if constexpr (End)
+                                owner->~linked_ptr();
+                        }
+                    }
+                    if (kept != end)
+                    {
+                        if constexpr (End)
+                            kept->~linked_ptr();
+                        else
+                            kept->destroy();
+                    }
+                    first = end;
+                }
+            }
+
+            template <typename T>
+            static weak_linked_ptr<T>& weak_this(enable_linked_from_this<T> const* base) noexcept
+            {
+                return base->weak_this;
             }
         };
     }
 
-    using namespace details;
+    template <typename T, typename... Args>
+    std::enable_if_t<!std::is_array_v<T>, linked_ptr<T>> make_linked(Args&&... args)
+    {
+        auto* header = new inplace_header<T>(std::forward<Args>(args)...);
+        return access::adopt<T>(header, header->get());
+    }
+
+    template <typename T>
+    std::enable_if_t<!std::is_array_v<T>, linked_ptr<T>> make_linked_for_overwrite()
+    {
+        auto* header = new inplace_header<T>(for_overwrite_t());
+        return access::adopt<T>(header, header->get());
+    }
+
+    namespace details
+    {
+        template <typename T, typename Init>
+        linked_ptr<T> make_linked_array(std::size_t size, Init init)
+        {
+            auto* header = array_header<std::remove_extent_t<T>>::create(size, init);
+            return access::adopt<T>(header, header->get());
+        }
+    }
+
+    // Arrays: the elements follow the ring header in one allocation and
+    // are value-initialized, copied from `value`, or default-initialized
+    // by make_linked_for_overwrite.
+    template <typename T>
+    std::enable_if_t<is_unbounded_array_v<T>, linked_ptr<T>> make_linked(std::size_t size)
+    {
+        using E = std::remove_cv_t<std::remove_extent_t<T>>;
+        return details::make_linked_array<T>(size, [](void* p) { ::new (p) E(); });
+    }
+
+    template <typename T>
+    std::enable_if_t<is_unbounded_array_v<T>, linked_ptr<T>> make_linked(std::size_t size, std::remove_extent_t<T> const& value)
+    {
+        using E = std::remove_cv_t<std::remove_extent_t<T>>;
+        return details::make_linked_array<T>(size, [&value](void* p) { ::new (p) E(value); });
+    }
+
+    template <typename T>
+    std::enable_if_t<is_unbounded_array_v<T>, linked_ptr<T>> make_linked_for_overwrite(std::size_t size)
+    {
+        using E = std::remove_cv_t<std::remove_extent_t<T>>;
+        return details::make_linked_array<T>(size, [](void* p) { ::new (p) E; });
+    }
+
+    template <typename T>
+    std::enable_if_t<is_bounded_array_v<T>, linked_ptr<T>> make_linked()
+    {
+        using E = std::remove_cv_t<std::remove_extent_t<T>>;
+        return details::make_linked_array<T>(std::extent_v<T>, [](void* p) { ::new (p) E(); });
+    }
+
+    template <typename T>
+    std::enable_if_t<is_bounded_array_v<T>, linked_ptr<T>> make_linked(std::remove_extent_t<T> const& value)
+    {
+        using E = std::remove_cv_t<std::remove_extent_t<T>>;
+        return details::make_linked_array<T>(std::extent_v<T>, [&value](void* p) { ::new (p) E(value); });
+    }
+
+    template <typename T>
+    std::enable_if_t<is_bounded_array_v<T>, linked_ptr<T>> make_linked_for_overwrite()
+    {
+        using E = std::remove_cv_t<std::remove_extent_t<T>>;
+        return details::make_linked_array<T>(std::extent_v<T>, [](void* p) { ::new (p) E; });
+    }
+
+    template <typename T, typename Alloc, typename... Args>
+    std::enable_if_t<!std::is_array_v<T>, linked_ptr<T>> allocate_linked(Alloc const& alloc, Args&&... args)
+    {
+        auto* header = allocated_header<T, Alloc>::create(alloc, std::forward<Args>(args)...);
+        return access::adopt<T>(header, header->get());
+    }
+
+    namespace pmr
+    {
+        template <typename T, typename... Args>
+        linked_ptr<T> allocate_linked(std::pmr::memory_resource* resource, Args&&... args)
+        {
+            return smart_ptr::allocate_linked<T>(std::pmr::polymorphic_allocator<T>(resource), std::forward<Args>(args)...);
+        }
+    }
+
+// casts
+    template <typename T, typename U, typename E>
+    linked_ptr<T> static_linked_cast(linked_ptr<U, E> const& source)
+    {
+        return access::cast<T>(source, static_cast<std::remove_extent_t<T>*>(source.get()));
+    }
+
+    template <typename T, typename U, typename E>
+    linked_ptr<T> static_linked_cast(linked_ptr<U, E>&& source)
+    {
+        return access::cast<T>(std::move(source), static_cast<std::remove_extent_t<T>*>(source.get()));
+    }
+
+    // A failed cast returns an empty pointer and leaves an rvalue source
+    // untouched.
+    template <typename T, typename U, typename E>
+    linked_ptr<T> dynamic_linked_cast(linked_ptr<U, E> const& source)
+    {
+        return access::cast<T>(source, dynamic_cast<std::remove_extent_t<T>*>(source.get()));
+    }
+
+    template <typename T, typename U, typename E>
+    linked_ptr<T> dynamic_linked_cast(linked_ptr<U, E>&& source)
+    {
+        return access::cast<T>(std::move(source), dynamic_cast<std::remove_extent_t<T>*>(source.get()));
+    }
+
+    template <typename T, typename U, typename E>
+    linked_ptr<T> const_linked_cast(linked_ptr<U, E> const& source)
+    {
+        return access::cast<T>(source, const_cast<std::remove_extent_t<T>*>(source.get()));
+    }
+
+    template <typename T, typename U, typename E>
+    linked_ptr<T> const_linked_cast(linked_ptr<U, E>&& source)
+    {
+        return access::cast<T>(std::move(source), const_cast<std::remove_extent_t<T>*>(source.get()));
+    }
+
+    // The result never deletes through the reinterpreted pointer: it is
+    // an alias, and the ring's header owns the object.
+    template <typename T, typename U, typename E>
+    linked_ptr<T> reinterpret_linked_cast(linked_ptr<U, E> const& source)
+    {
+        return linked_ptr<T>(source, reinterpret_cast<std::remove_extent_t<T>*>(source.get()));
+    }
 
+    template <typename T, typename U, typename E>
+    linked_ptr<T> reinterpret_linked_cast(linked_ptr<U, E>&& source)
+    {
+        auto* pointer = reinterpret_cast<std::remove_extent_t<T>*>(source.get());
+        return linked_ptr<T>(std::move(source), pointer);
+    }
+
+
+    // Observes the object of a ring without owning it. The first weak
+    // observer of a ring without a header allocates one; owners do not
+    // grow and rings that are never observed pay nothing.
     template <typename T>
-    class linked_ptr
+    class weak_linked_ptr
     {
         template <typename U>
-        friend class linked_ptr;
+        friend class weak_linked_ptr;
+
+        friend struct details::access;
+
+    public:
+        using element_type = std::remove_extent_t<T>;
 
     private:
-        mutable volatile intrusive_mixin intrusive_node;
-        T* pointer;
+        ring_header* header;
+        element_type* pointer;
 
     public:
 // constructors / destructor
-        constexpr linked_ptr() noexcept : intrusive_node(), pointer(nullptr) {}
+        constexpr weak_linked_ptr() noexcept : header(nullptr), pointer(nullptr) {}
 
-        explicit linked_ptr(T* pointer) noexcept : intrusive_node(), pointer(pointer) {}
+        template <typename U, typename E, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+        weak_linked_ptr(linked_ptr<U, E> const& owner) : header(access::make_header(owner)), pointer(owner.get())
+        {
+            if (header)
+                header->add_weak();
+        }
 
-        linked_ptr(linked_ptr const& other) : intrusive_node(), pointer(other.get())
+        weak_linked_ptr(weak_linked_ptr const& other) noexcept : header(other.header), pointer(other.pointer)
         {
-            other.attach(*this);
+            if (header)
+                header->add_weak();
         }
 
-        template <typename U, typename = std::enable_if<std::is_convertible_v<U*, T*>>>
-        explicit linked_ptr(U* pointer) : intrusive_node(), pointer(pointer) {}
+        weak_linked_ptr(weak_linked_ptr&& other) noexcept : header(other.header), pointer(other.pointer)
+        {
+            other.header = nullptr;
+            other.pointer = nullptr;
+        }
 
-        template <typename U, typename = std::enable_if<std::is_convertible_v<U*, T*>>>
-        linked_ptr(linked_ptr<U> const& other) : intrusive_node(), pointer(other.get())
+        template <typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+        weak_linked_ptr(weak_linked_ptr<U> const& other) noexcept : header(other.header), pointer(other.pointer)
         {
-            other.attach(*this);
+            if (header)
+                header->add_weak();
         }
 
-        ~linked_ptr()
+        ~weak_linked_ptr()
         {
-            destroy();
+            if (header)
+                header->drop_weak();
         }
 
 // assign operators
-        linked_ptr& operator=(linked_ptr const& other) noexcept
+        weak_linked_ptr& operator=(weak_linked_ptr const& other) noexcept
         {
-            auto tmp(other);
+            weak_linked_ptr tmp(other);
             swap(tmp);
             return *this;
         }
 
-        template <typename U, typename = std::enable_if<std::is_convertible_v<U*, T*>>>
-        linked_ptr& operator=(linked_ptr<U> const& other)
+        weak_linked_ptr& operator=(weak_linked_ptr&& other) noexcept
         {
-            auto tmp(other);
+            weak_linked_ptr tmp(std::move(other));
             swap(tmp);
             return *this;
         }
 
-// common smart pointer interface
-        template <typename U = T, typename = std::enable_if<std::is_convertible_v<U*, T*>>>
-        void reset(U* new_pointer = nullptr)
+        template <typename U, typename E, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+        weak_linked_ptr& operator=(linked_ptr<U, E> const& owner)
         {
-            destroy();
-            pointer = new_pointer;
+            weak_linked_ptr tmp(owner);
+            swap(tmp);
+            return *this;
         }
 
-        void swap(linked_ptr& other) noexcept
+// weak pointer interface
+        void reset() noexcept
         {
-            intrusive_node.swap(other.intrusive_node);
-            std::swap(pointer, other.pointer);
+            weak_linked_ptr().swap(*this);
         }
 
-        T* get() const noexcept
+        void swap(weak_linked_ptr& other) noexcept
         {
-            return pointer;
+            std::swap(header, other.header);
+            std::swap(pointer, other.pointer);
         }
 
-        bool unique() const noexcept
+        bool expired() const noexcept
         {
-            return !intrusive_node.l && !intrusive_node.r && pointer;
+            return !header || header->destroyed;
         }
 
-        operator bool() const noexcept
+        std::size_t use_count() const noexcept
         {
-            return get();
+            return expired() ? 0 : header->use_count();
         }
 
-// pointer using interface
-        T& operator*() const
+        linked_ptr<T> lock() const noexcept
         {
-            return *get();
+            if (expired())
+                return linked_ptr<T>();
+            return access::adopt<T>(header, pointer);
         }
 
-        T* operator->() const
+    private:
+        weak_linked_ptr(ring_header* header, element_type* pointer) noexcept : header(header), pointer(pointer)
         {
-            return get();
+            if (header)
+                header->add_weak();
         }
+    };
+
+    template <typename T>
+    void swap(weak_linked_ptr<T> &a, weak_linked_ptr<T> &b) noexcept
+    {
+        a.swap(b);
+    }
+
+    // Lets an object owned by linked_ptr hand out owners of itself. Every
+    // linked_ptr constructor that takes ownership of a raw pointer, and
+    // make_linked, records the ring in the object, so linked_from_this()
+    // joins it right after its header in constant time.
+    template <typename T>
+    class enable_linked_from_this : public details::linked_from_this_tag
+    {
+        friend struct details::access;
 
     private:
-        template <typename U = T, typename = std::enable_if<std::is_convertible_v<U*, T*>>>
-        void attach(linked_ptr<U> const& copy) const noexcept
+        mutable weak_linked_ptr<T> weak_this;
+
+    protected:
+        enable_linked_from_this() noexcept = default;
+
+        enable_linked_from_this(enable_linked_from_this const&) noexcept {}
+
+        enable_linked_from_this& operator=(enable_linked_from_this const&) noexcept
         {
-            intrusive_node.attach(&copy.intrusive_node);
+            return *this;
         }
 
-        void detach() const noexcept
+        ~enable_linked_from_this() = default;
+
+    public:
+        linked_ptr<T> linked_from_this()
         {
-            intrusive_node.detach();
+            return weak_this.lock();
         }
 
-        void destroy()
+        linked_ptr<T const> linked_from_this() const
         {
-            //enum {T_have_to_be_complete = sizeof(T)};
-            if (unique() && pointer)
-            {
-                delete pointer;
-            }
-            pointer = nullptr;
-            intrusive_node.detach();
+            return weak_this.lock();
+        }
+
+        weak_linked_ptr<T> weak_from_this() noexcept
+        {
+            return weak_this;
+        }
+
+        weak_linked_ptr<T const> weak_from_this() const noexcept
+        {
+            return weak_this;
         }
     };
 
+    namespace details
+    {
+        template <typename X, typename U, typename Owner>
+        void set_weak_this(enable_linked_from_this<X> const* base, U* raw, Owner const& owner)
+        {
+            weak_linked_ptr<X>& weak_this = access::weak_this(base);
+            if (weak_this.expired())
+                weak_this = access::make_weak<X>(access::make_header(owner), static_cast<X*>(const_cast<std::remove_cv_t<U>*>(raw)));
+        }
+    }
 
-    template <typename T, typename U>
-    inline bool operator==(linked_ptr<T> const& a, linked_ptr<U> const& b) noexcept
+    template <typename T, typename D, typename U, typename E>
+    inline bool operator==(linked_ptr<T, D> const& a, linked_ptr<U, E> const& b) noexcept
     {
         return a.get() == b.get();
     }
 
-    template <typename T, typename U>
-    inline bool operator!=(linked_ptr<T> const& a, linked_ptr<U> const& b) noexcept
+    template <typename T, typename D, typename U, typename E>
+    inline bool operator!=(linked_ptr<T, D> const& a, linked_ptr<U, E> const& b) noexcept
     {
         return !(a == b);
     }
 
-    template <typename T, typename U>
-    inline bool operator<(linked_ptr<T> const& a, linked_ptr<U> const& b) noexcept
+    template <typename T, typename D, typename U, typename E>
+    inline bool operator<(linked_ptr<T, D> const& a, linked_ptr<U, E> const& b) noexcept
     {
         return a.get() < b.get();
     }
 
-    template <typename T, typename U>
-    inline bool operator>(linked_ptr<T> const& a, linked_ptr<U> const& b) noexcept
+    template <typename T, typename D, typename U, typename E>
+    inline bool operator>(linked_ptr<T, D> const& a, linked_ptr<U, E> const& b) noexcept
     {
         return b < a;
     }
 
-    template <typename T, typename U>
-    inline bool operator<=(linked_ptr<T> const& a, linked_ptr<U> const& b) noexcept
+    template <typename T, typename D, typename U, typename E>
+    inline bool operator<=(linked_ptr<T, D> const& a, linked_ptr<U, E> const& b) noexcept
     {
         return a < b || a == b;
     }
 
-    template <typename T, typename U>
-    inline bool operator>=(linked_ptr<T> const& a, linked_ptr<U> const& b) noexcept
+    template <typename T, typename D, typename U, typename E>
+    inline bool operator>=(linked_ptr<T, D> const& a, linked_ptr<U, E> const& b) noexcept
     {
         return (b <= a);
     }
 
-    template <typename T>
-    void swap(linked_ptr<T> &a, linked_ptr<T> &b) noexcept
+    template <typename T, typename D>
+    void swap(linked_ptr<T, D> &a, linked_ptr<T, D> &b) noexcept
     {
         a.swap(b);
     }
+
+    namespace details
+    {
+        template <typename T, typename D>
+        typename linked_ptr<T, D>::element_type* address_of(linked_ptr<T, D> const& p) noexcept
+        {
+            return p.get();
+        }
+
+        template <typename T>
+        T* address_of(T* p) noexcept
+        {
+            return p;
+        }
+
+        // The type both operands convert to, so that a derived pointer
+        // is adjusted to the base subobject it is compared with; plain
+        // addresses for unrelated types.
+        template <typename P, typename Q, typename = void>
+        struct common_pointer
+        {
+            using type = void const volatile*;
+        };
+
+        template <typename P, typename Q>
+        struct common_pointer<P, Q, std::void_t<std::common_type_t<P, Q>>>
+        {
+            using type = std::common_type_t<P, Q>;
+        };
+
+        template <typename A, typename B>
+        using common_pointer_t = typename common_pointer<decltype(address_of(std::declval<A const&>())),
+                                                         decltype(address_of(std::declval<B const&>()))>::type;
+    }
+
+    // Function objects for containers of linked_ptr: they accept any
+    // linked_ptr and raw pointers alike and look at the stored pointer
+    // only. linked_ptr_less is transparent, so lookups in ordered
+    // containers by T* need no temporary owner and never touch a ring.
+    // Operands are compared as their common pointer type; pointers to
+    // unrelated types are compared as plain addresses.
+    struct linked_ptr_less
+    {
+        using is_transparent = void;
+
+        template <typename A, typename B>
+        bool operator()(A const& a, B const& b) const noexcept
+        {
+            using pointer = details::common_pointer_t<A, B>;
+            return std::less<pointer>()(details::address_of(a), details::address_of(b));
+        }
+    };
+
+    // Unordered containers only use heterogeneous lookup from C++20 on,
+    // so the two below are not marked transparent.
+    struct linked_ptr_equal_to
+    {
+        template <typename A, typename B>
+        bool operator()(A const& a, B const& b) const noexcept
+        {
+            using pointer = details::common_pointer_t<A, B>;
+            return static_cast<pointer>(details::address_of(a)) == static_cast<pointer>(details::address_of(b));
+        }
+    };
+
+    struct linked_ptr_hash
+    {
+        template <typename A>
+        std::size_t operator()(A const& a) const noexcept
+        {
+            return std::hash<decltype(details::address_of(a))>()(details::address_of(a));
+        }
+    };
+}
+
+namespace std
+{
+    template <typename T, typename D>
+    struct hash<smart_ptr::linked_ptr<T, D>>
+    {
+        std::size_t operator()(smart_ptr::linked_ptr<T, D> const& p) const noexcept
+        {
+            return std::hash<typename smart_ptr::linked_ptr<T, D>::element_type*>()(p.get());
+        }
+    };
 }
 
 #endif
@@ -0,0 +1,250 @@
+#ifndef LINKED_PTR_ALGORITHM_H
+#define LINKED_PTR_ALGORITHM_H
+
+#include "linked_ptr.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace smart_ptr
+{
+    // Relocation moves objects to raw storage and leaves raw storage
+    // behind, as one operation. relocate_n is the customization point:
+    // types overload it in their own namespace, found by argument
+    // dependent lookup. This fallback move-constructs and destroys, and
+    // handles overlapping ranges in either direction.
+    template <typename T>
+    T* relocate_n(T* first, std::size_t n, T* dest)
+    {
+        if (first == dest || n == 0)
+            return dest + n;
+        if (dest < first)
+        {
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                ::new (static_cast<void*>(dest + i)) T(std::move(first[i]));
+                first[i].~T();
+            }
+        }
+        else
+        {
+            for (std::size_t i = n; i != 0; --i)
+            {
+                ::new (static_cast<void*>(dest + i - 1)) T(std::move(first[i - 1]));
+                first[i - 1].~T();
+            }
+        }
+        return dest + n;
+    }
+
+    // Owners are copied bitwise and their ring neighbours patched once.
+    template <typename T, typename D>
+    linked_ptr<T, D>* relocate_n(linked_ptr<T, D>* first, std::size_t n, linked_ptr<T, D>* dest) noexcept
+    {
+        details::access::relocate(first, n, dest);
+        return dest + n;
+    }
+
+    template <typename T>
+    T* relocate(T* first, T* last, T* dest)
+    {
+        return relocate_n(first, static_cast<std::size_t>(last - first), dest);
+    }
+
+    namespace details
+    {
+        // Raw storage for up to `size` elements, allocated without
+        // throwing; empty if that fails.
+        template <typename T>
+        class relocation_buffer
+        {
+        private:
+            T* memory;
+
+        public:
+            explicit relocation_buffer(std::size_t size) noexcept
+                : memory(static_cast<T*>(::operator new(size * sizeof(T), std::nothrow))) {}
+
+            relocation_buffer(relocation_buffer const&) = delete;
+            relocation_buffer& operator=(relocation_buffer const&) = delete;
+
+            ~relocation_buffer()
+            {
+                ::operator delete(static_cast<void*>(memory));
+            }
+
+            T* get() const noexcept
+            {
+                return memory;
+            }
+        };
+
+        std::size_t const swap_chunk = 64;
+    }
+
+    // The algorithms below work on contiguous ranges of linked_ptr and
+    // move every owner by relocation instead of the copy/swap sequence
+    // of assignment. Owners that share a ring and move together cost no
+    // link writes at all.
+
+    // Like std::rotate; returns the new position of *first.
+    template <typename T, typename D>
+    linked_ptr<T, D>* rotate(linked_ptr<T, D>* first, linked_ptr<T, D>* middle, linked_ptr<T, D>* last)
+    {
+        if (first == middle)
+            return last;
+        if (middle == last)
+            return first;
+        auto left = static_cast<std::size_t>(middle - first);
+        auto right = static_cast<std::size_t>(last - middle);
+        details::relocation_buffer<linked_ptr<T, D>> buffer(std::min(left, right));
+        if (!buffer.get())
+            return std::rotate(first, middle, last);
+        if (left <= right)
+        {
+            relocate_n(first, left, buffer.get());
+            relocate_n(middle, right, first);
+            relocate_n(buffer.get(), left, first + right);
+        }
+        else
+        {
+            relocate_n(middle, right, buffer.get());
+            relocate_n(first, left, first + right);
+            relocate_n(buffer.get(), right, first);
+        }
+        return first + right;
+    }
+
+    // Like std::swap_ranges for ranges that do not overlap; swaps in
+    // chunks staged in a small buffer on the stack.
+    template <typename T, typename D>
+    linked_ptr<T, D>* swap_ranges(linked_ptr<T, D>* first1, linked_ptr<T, D>* last1, linked_ptr<T, D>* first2) noexcept
+    {
+        alignas(linked_ptr<T, D>) unsigned char storage[details::swap_chunk * sizeof(linked_ptr<T, D>)];
+        auto* buffer = reinterpret_cast<linked_ptr<T, D>*>(storage);
+        while (first1 != last1)
+        {
+            std::size_t n = std::min(details::swap_chunk, static_cast<std::size_t>(last1 - first1));
+            relocate_n(first1, n, buffer);
+            relocate_n(first2, n, first1);
+            relocate_n(buffer, n, first2);
+            first1 += n;
+            first2 += n;
+        }
+        return first2;
+    }
+
+    // Releases every owner of the range and leaves them empty; runs of
+    // consecutive owners that are also ring neighbours are unlinked with
+    // one splice each.
+    template <typename T, typename D>
+    void reset_range(linked_ptr<T, D>* first, linked_ptr<T, D>* last) noexcept
+    {
+        details::access::reset_range<false>(first, last);
+    }
+
+    // Like std::destroy, with the release of reset_range.
+    template <typename T, typename D>
+    void destroy_range(linked_ptr<T, D>* first, linked_ptr<T, D>* last) noexcept
+    {
+        details::access::reset_range<true>(first, last);
+    }
+
+    template <typename T, typename D, typename Alloc>
+    void clear(std::vector<linked_ptr<T, D>, Alloc>& owners) noexcept
+    {
+        reset_range(owners.data(), owners.data() + owners.size());
+        owners.clear();
+    }
+
+    namespace details
+    {
+        // Moves first[source[i]] to first[i] for every i. With a scratch
+        // block the owners are gathered in order and every link is fixed
+        // in one sequential pass; otherwise the cycles of the permutation
+        // are followed, relocating every owner once plus once per cycle.
+        // Consumes `source`.
+        template <typename T, typename D>
+        void apply_permutation(linked_ptr<T, D>* first, std::vector<std::size_t>& source) noexcept
+        {
+            std::size_t n = source.size();
+            if constexpr (std::is_trivially_copyable_v<D>)
+            {
+                relocation_buffer<linked_ptr<T, D>> buffer(n);
+                relocation_buffer<std::size_t> target(n);
+                if (buffer.get() && target.get())
+                {
+                    for (std::size_t i = 0; i < n; ++i)
+                        target.get()[source[i]] = i;
+                    access::permute(first, n, source.data(), target.get(), buffer.get());
+                    return;
+                }
+            }
+            alignas(linked_ptr<T, D>) unsigned char storage[sizeof(linked_ptr<T, D>)];
+            auto* hole = reinterpret_cast<linked_ptr<T, D>*>(storage);
+            for (std::size_t start = 0; start < n; ++start)
+            {
+                if (source[start] == start)
+                    continue;
+                relocate_n(first + start, 1, hole);
+                std::size_t position = start;
+                while (source[position] != start)
+                {
+                    std::size_t next = source[position];
+                    relocate_n(first + next, 1, first + position);
+                    source[position] = position;
+                    position = next;
+                }
+                relocate_n(hole, 1, first + position);
+                source[position] = position;
+            }
+        }
+    }
+
+    // Sorts indices of the owners first, so nothing moves if comparing or
+    // allocating throws, then moves every owner straight to its place.
+    template <typename T, typename D, typename Compare>
+    void sort(linked_ptr<T, D>* first, linked_ptr<T, D>* last, Compare comp)
+    {
+        auto n = static_cast<std::size_t>(last - first);
+        if (n < 2)
+            return;
+        std::vector<std::size_t> source(n);
+        std::iota(source.begin(), source.end(), std::size_t(0));
+        std::sort(source.begin(), source.end(), [first, &comp](std::size_t a, std::size_t b)
+        {
+            return comp(first[a], first[b]);
+        });
+        details::apply_permutation(first, source);
+    }
+
+    // Orders by stored pointer, like operator<. The pointers are sorted
+    // next to their indices, so comparisons do not reach into the range.
+    template <typename T, typename D>
+    void sort(linked_ptr<T, D>* first, linked_ptr<T, D>* last)
+    {
+        auto n = static_cast<std::size_t>(last - first);
+        if (n < 2)
+            return;
+        using key = std::pair<typename linked_ptr<T, D>::element_type*, std::size_t>;
+        std::vector<key> keys(n);
+        for (std::size_t i = 0; i < n; ++i)
+            keys[i] = key(first[i].get(), i);
+        std::sort(keys.begin(), keys.end(), [](key const& a, key const& b)
+        {
+            return std::less<typename linked_ptr<T, D>::element_type*>()(a.first, b.first);
+        });
+        std::vector<std::size_t> source(n);
+        for (std::size_t i = 0; i < n; ++i)
+            source[i] = keys[i].second;
+        keys = std::vector<key>();
+        details::apply_permutation(first, source);
+    }
+}
+
+#endif
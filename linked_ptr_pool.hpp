@@ -0,0 +1,202 @@
+#ifndef LINKED_PTR_POOL_H
+#define LINKED_PTR_POOL_H
+
+#include "linked_ptr.hpp"
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace smart_ptr
+{
+    namespace details
+    {
+        template <typename Traits, typename = void>
+        struct pool_limit : std::integral_constant<std::size_t, default_pool_high_water_mark> {};
+
+        template <typename Traits>
+        struct pool_limit<Traits, std::void_t<decltype(Traits::pool_high_water_mark)>>
+            : std::integral_constant<std::size_t, Traits::pool_high_water_mark> {};
+
+        // Blocks of one size kept by a thread. Trivially destructible, so
+        // it stays usable while the thread exits; the reaper frees the
+        // blocks then and closes the list, after which blocks are freed
+        // right away.
+        struct free_list
+        {
+            void* head;
+            std::size_t size;
+            bool registered;
+            bool closed;
+        };
+
+        template <typename Header>
+        class pool_blocks
+        {
+        private:
+            static constexpr bool over_aligned = alignof(Header) > __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+            struct reaper
+            {
+                ~reaper()
+                {
+                    trim();
+                    list().closed = true;
+                }
+            };
+
+            static free_list& list() noexcept
+            {
+                thread_local free_list blocks{nullptr, 0, false, false};
+                return blocks;
+            }
+
+            static void free_block(void* block) noexcept
+            {
+                if constexpr (over_aligned)
+                    ::operator delete(block, std::align_val_t(alignof(Header)));
+                else
+                    ::operator delete(block);
+            }
+
+        public:
+            static void* take()
+            {
+                free_list& blocks = list();
+                if (void* block = blocks.head)
+                {
+                    blocks.head = *static_cast<void**>(block);
+                    --blocks.size;
+                    return block;
+                }
+                if constexpr (over_aligned)
+                    return ::operator new(sizeof(Header), std::align_val_t(alignof(Header)));
+                else
+                    return ::operator new(sizeof(Header));
+            }
+
+            static void put(void* block, std::size_t limit) noexcept
+            {
+                free_list& blocks = list();
+                if (blocks.closed || blocks.size >= limit)
+                {
+                    free_block(block);
+                    return;
+                }
+                if (!blocks.registered)
+                {
+                    thread_local reaper on_exit;
+                    (void) on_exit;
+                    blocks.registered = true;
+                }
+                *static_cast<void**>(block) = blocks.head;
+                blocks.head = block;
+                ++blocks.size;
+            }
+
+            static std::size_t size() noexcept
+            {
+                return list().size;
+            }
+
+            static void trim() noexcept
+            {
+                free_list& blocks = list();
+                while (void* block = blocks.head)
+                {
+                    blocks.head = *static_cast<void**>(block);
+                    free_block(block);
+                }
+                blocks.size = 0;
+            }
+        };
+
+        template <typename T>
+        class pool_header final : public ring_header
+        {
+        private:
+            using blocks = pool_blocks<pool_header>;
+
+            alignas(T) unsigned char storage[sizeof(T)];
+
+        public:
+            template <typename... Args>
+            explicit pool_header(Args&&... args)
+            {
+                ::new (static_cast<void*>(storage)) std::remove_cv_t<T>(std::forward<Args>(args)...);
+            }
+
+            template <typename... Args>
+            static pool_header* create(Args&&... args)
+            {
+                void* block = blocks::take();
+                try
+                {
+                    return ::new (block) pool_header(std::forward<Args>(args)...);
+                }
+                catch (...)
+                {
+                    blocks::put(block, pool_limit<linked_ptr_traits<std::remove_cv_t<T>>>::value);
+                    throw;
+                }
+            }
+
+            std::remove_cv_t<T>* get() noexcept
+            {
+                return std::launder(reinterpret_cast<std::remove_cv_t<T>*>(storage));
+            }
+
+        private:
+            void destroy_object() noexcept override
+            {
+                get()->~T();
+            }
+
+            void deallocate() noexcept override
+            {
+                this->~pool_header();
+                blocks::put(this, pool_limit<linked_ptr_traits<std::remove_cv_t<T>>>::value);
+            }
+        };
+    }
+
+    // Hands out objects of T whose memory, header included, goes back to
+    // a free list of the releasing thread instead of operator delete. The
+    // object is destroyed when its last owner goes away and a new one is
+    // constructed in the block on reuse. Each thread keeps at most
+    // linked_ptr_traits<T>::pool_high_water_mark blocks and frees the rest.
+    template <typename T>
+    class linked_pool
+    {
+        static_assert(!std::is_array_v<T>, "linked_pool does not hold arrays");
+
+    private:
+        using header_type = details::pool_header<T>;
+        using blocks = details::pool_blocks<header_type>;
+
+    public:
+        static constexpr std::size_t high_water_mark = details::pool_limit<linked_ptr_traits<std::remove_cv_t<T>>>::value;
+
+        template <typename... Args>
+        static linked_ptr<T> make(Args&&... args)
+        {
+            auto* header = header_type::create(std::forward<Args>(args)...);
+            return access::adopt<T>(header, header->get());
+        }
+
+        // Blocks kept by the calling thread.
+        static std::size_t cached() noexcept
+        {
+            return blocks::size();
+        }
+
+        // Frees the blocks kept by the calling thread.
+        static void trim() noexcept
+        {
+            blocks::trim();
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,322 @@
+#ifndef LINKED_PTR_RECLAIMER_H
+#define LINKED_PTR_RECLAIMER_H
+
+#include "linked_ptr.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace smart_ptr
+{
+    // What a submitting thread does when a reclaimer already holds
+    // max_pending objects.
+    enum class reclaim_overflow
+    {
+        block,
+        destroy_inline
+    };
+
+    namespace details
+    {
+        inline bool& reclaiming() noexcept
+        {
+            thread_local bool inside = false;
+            return inside;
+        }
+    }
+
+    // Destroys deferred objects off the threads that released them. Once
+    // installed, threads collect objects of types with defer_destruction
+    // in batches and push full batches onto a lock-free queue; a thread
+    // of the reclaimer's own, or tasks given to an executor, run the
+    // destructors and free the memory. Objects with weak observers stay
+    // on their thread's queue for drain_deferred, since releasing them
+    // touches the header the observers share. The destructors of handed
+    // off objects must be safe to run on another thread.
+    //
+    // Threads keep a partial batch until it fills, drain_deferred is
+    // called or flush() runs on them. The reclaimer must not be installed,
+    // uninstalled or destroyed while other threads release objects.
+    class reclaimer final : private details::deferred_sink
+    {
+    public:
+        using executor = std::function<void(std::function<void()>)>;
+
+    private:
+        struct batch
+        {
+            batch* next;
+            std::vector<details::deferred_entry> entries;
+        };
+
+        std::size_t const entries_per_batch;
+        std::size_t const max_pending;
+        reclaim_overflow const when_full;
+        executor run_elsewhere;
+
+        std::atomic<batch*> incoming{nullptr};
+        std::atomic<std::size_t> pending_objects{0};
+        std::atomic<std::uint64_t> submitted{0};
+        std::atomic<std::uint64_t> completed{0};
+        std::atomic<std::size_t> waiters{0};
+        std::atomic<bool> idle{false};
+        std::atomic<bool> stopping{false};
+        std::atomic<bool> scheduled{false};
+
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable progress;
+        std::thread worker;
+
+    public:
+// constructors / destructor
+        // Starts a thread that destroys every batch as it arrives.
+        explicit reclaimer(std::size_t batch_size = 256, std::size_t max_pending = 65536,
+                           reclaim_overflow when_full = reclaim_overflow::block)
+            : entries_per_batch(batch_size ? batch_size : 1), max_pending(max_pending), when_full(when_full)
+        {
+            worker = std::thread([this]
+            {
+                details::reclaiming() = true;
+                run_thread();
+            });
+        }
+
+        // Hands `run` a task whenever batches arrive and none is running;
+        // the task destroys batches until it finds the queue empty.
+        explicit reclaimer(executor run, std::size_t batch_size = 256, std::size_t max_pending = 65536,
+                           reclaim_overflow when_full = reclaim_overflow::block)
+            : entries_per_batch(batch_size ? batch_size : 1), max_pending(max_pending), when_full(when_full),
+              run_elsewhere(std::move(run)) {}
+
+        reclaimer(reclaimer const&) = delete;
+        reclaimer& operator=(reclaimer const&) = delete;
+
+        // Uninstalls the reclaimer and destroys everything submitted.
+        ~reclaimer()
+        {
+            uninstall();
+            if (worker.joinable())
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    stopping.store(true);
+                }
+                wake.notify_one();
+                worker.join();
+            }
+            else
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                progress.wait(lock, [this]
+                {
+                    return !scheduled.load() && incoming.load() == nullptr;
+                });
+            }
+        }
+
+// installation
+        void install() noexcept
+        {
+            details::installed_sink().store(this, std::memory_order_release);
+        }
+
+        void uninstall() noexcept
+        {
+            details::deferred_sink* self = this;
+            details::installed_sink().compare_exchange_strong(self, nullptr, std::memory_order_acq_rel);
+        }
+
+// synchronization
+        // Submits the calling thread's partial batch and waits until every
+        // batch submitted so far is destroyed. Must not be called from the
+        // reclaimer's own thread or tasks.
+        void flush() noexcept
+        {
+            details::deferred().hand_off();
+            std::uint64_t target = submitted.load();
+            std::unique_lock<std::mutex> lock(mutex);
+            ++waiters;
+            progress.wait(lock, [this, target]
+            {
+                return completed.load() >= target;
+            });
+            --waiters;
+        }
+
+        // Objects submitted and not destroyed yet.
+        std::size_t pending() const noexcept
+        {
+            return pending_objects.load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::size_t batch_size() const noexcept override
+        {
+            return entries_per_batch;
+        }
+
+        void submit(std::vector<details::deferred_entry>& entries) noexcept override
+        {
+            std::size_t n = entries.size();
+            if (pending_objects.load() + n > max_pending)
+            {
+                // The reclaimer's own thread never waits for itself.
+                if (when_full == reclaim_overflow::destroy_inline && !details::reclaiming())
+                {
+                    details::destroy_entries(entries);
+                    return;
+                }
+                if (!details::reclaiming())
+                    wait_for_room(n);
+            }
+            batch* b = new (std::nothrow) batch{nullptr, {}};
+            if (!b)
+            {
+                details::destroy_entries(entries);
+                return;
+            }
+            b->entries.swap(entries);
+            try
+            {
+                entries.reserve(entries_per_batch);
+            }
+            catch (...)
+            {
+            }
+            pending_objects.fetch_add(n);
+            submitted.fetch_add(1);
+            b->next = incoming.load(std::memory_order_relaxed);
+            while (!incoming.compare_exchange_weak(b->next, b))
+            {
+            }
+            notify();
+        }
+
+        void wait_for_room(std::size_t n) noexcept
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ++waiters;
+            progress.wait(lock, [this, n]
+            {
+                std::size_t now = pending_objects.load();
+                return now == 0 || now + n <= max_pending;
+            });
+            --waiters;
+        }
+
+        void notify() noexcept
+        {
+            if (!run_elsewhere)
+            {
+                if (idle.load())
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    wake.notify_one();
+                }
+                return;
+            }
+            if (scheduled.exchange(true))
+                return;
+            try
+            {
+                run_elsewhere([this]
+                {
+                    run_scheduled();
+                });
+            }
+            catch (...)
+            {
+                run_scheduled();
+            }
+        }
+
+        // Takes every queued batch and destroys them oldest first, then
+        // the objects this thread deferred meanwhile. False if there was
+        // nothing to take.
+        bool round() noexcept
+        {
+            batch* taken = incoming.exchange(nullptr);
+            if (!taken)
+                return false;
+            batch* oldest = nullptr;
+            while (taken)
+            {
+                batch* next = taken->next;
+                taken->next = oldest;
+                oldest = taken;
+                taken = next;
+            }
+            while (oldest)
+            {
+                batch* next = oldest->next;
+                std::size_t n = oldest->entries.size();
+                details::destroy_entries(oldest->entries);
+                delete oldest;
+                pending_objects.fetch_sub(n);
+                completed.fetch_add(1);
+                oldest = next;
+            }
+            drain_deferred();
+            if (waiters.load() != 0)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                progress.notify_all();
+            }
+            return true;
+        }
+
+        void run_thread() noexcept
+        {
+            for (;;)
+            {
+                if (round())
+                    continue;
+                if (stopping.load())
+                    return;
+                idle.store(true);
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [this]
+                    {
+                        return incoming.load() != nullptr || stopping.load();
+                    });
+                }
+                idle.store(false);
+            }
+        }
+
+        // Submitters schedule a task only when they flip `scheduled`; the
+        // task clears it under the mutex and looks for late batches once
+        // more, so none is left behind and the destructor can wait for it.
+        void run_scheduled() noexcept
+        {
+            bool outer = details::reclaiming();
+            details::reclaiming() = true;
+            for (;;)
+            {
+                while (round())
+                {
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                scheduled.store(false);
+                if (incoming.load() == nullptr || scheduled.exchange(true))
+                {
+                    progress.notify_all();
+                    break;
+                }
+            }
+            details::reclaiming() = outer;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef LINKED_PTR_REGION_H
+#define LINKED_PTR_REGION_H
+
+#include "linked_ptr.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace smart_ptr
+{
+    namespace details
+    {
+        // Shared by a region and the headers it holds; the last of them
+        // returns every block to the upstream resource at once. Headers
+        // may be released on other threads, e.g. by a reclaimer.
+        class region_state
+        {
+        public:
+            std::pmr::monotonic_buffer_resource memory;
+            std::atomic<std::size_t> references{1};
+
+            region_state(std::size_t initial_size, std::pmr::memory_resource* upstream)
+                : memory(initial_size, upstream) {}
+
+            void add_reference() noexcept
+            {
+                references.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            void drop_reference() noexcept
+            {
+                if (references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    delete this;
+            }
+        };
+
+        template <typename T>
+        class region_header final : public ring_header
+        {
+        private:
+            region_state* region;
+            alignas(T) unsigned char storage[sizeof(T)];
+
+        public:
+            template <typename... Args>
+            explicit region_header(region_state* region, Args&&... args) : region(region)
+            {
+                ::new (static_cast<void*>(storage)) std::remove_cv_t<T>(std::forward<Args>(args)...);
+            }
+
+            std::remove_cv_t<T>* get() noexcept
+            {
+                return std::launder(reinterpret_cast<std::remove_cv_t<T>*>(storage));
+            }
+
+        private:
+            void destroy_object() noexcept override
+            {
+                get()->~T();
+            }
+
+            // The memory stays with the region until it is freed as a whole.
+            void deallocate() noexcept override
+            {
+                region_state* owner = region;
+                this->~region_header();
+                owner->drop_reference();
+            }
+        };
+    }
+
+    // Objects built by make() live in a monotonic arena together with
+    // their headers. Releasing the last owner runs the destructor and
+    // frees nothing; the arena's blocks are returned in one go once the
+    // region and every header in it are gone, so owners may outlive the
+    // region object.
+    class linked_region
+    {
+    private:
+        details::region_state* state;
+
+    public:
+// constructors / destructor
+        explicit linked_region(std::size_t initial_size = 4096,
+                               std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+            : state(new details::region_state(initial_size, upstream)) {}
+
+        linked_region(linked_region const&) = delete;
+        linked_region& operator=(linked_region const&) = delete;
+
+        ~linked_region()
+        {
+            state->drop_reference();
+        }
+
+// allocation
+        template <typename T, typename... Args>
+        std::enable_if_t<!std::is_array_v<T>, linked_ptr<T>> make(Args&&... args)
+        {
+            using header_type = details::region_header<T>;
+            void* memory = state->memory.allocate(sizeof(header_type), alignof(header_type));
+            auto* header = ::new (memory) header_type(state, std::forward<Args>(args)...);
+            state->add_reference();
+            return access::adopt<T>(header, header->get());
+        }
+
+        // For members of the objects, e.g. std::pmr containers, that
+        // should live in the arena as well.
+        std::pmr::memory_resource* resource() const noexcept
+        {
+            return &state->memory;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,321 @@
+#ifndef LINKED_PTR_VECTOR_H
+#define LINKED_PTR_VECTOR_H
+
+#include "linked_ptr.hpp"
+#include "linked_ptr_algorithm.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+
+namespace smart_ptr
+{
+    // A vector of owners that grows, inserts and erases by relocating its
+    // elements: they are copied bitwise and only the links of ring
+    // neighbours outside the moved block are patched. Owners sharing a
+    // ring inside the block keep linking to each other without any write.
+    template <typename T, typename D = default_delete<T>>
+    class linked_ptr_vector
+    {
+    public:
+        using value_type = linked_ptr<T, D>;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using reference = value_type&;
+        using const_reference = value_type const&;
+        using pointer = value_type*;
+        using const_pointer = value_type const*;
+        using iterator = value_type*;
+        using const_iterator = value_type const*;
+
+    private:
+        value_type* first;
+        size_type count;
+        size_type storage;
+
+        static value_type* allocate(size_type n)
+        {
+            if (n > static_cast<size_type>(-1) / sizeof(value_type))
+                throw std::length_error("linked_ptr_vector");
+            return static_cast<value_type*>(::operator new(n * sizeof(value_type)));
+        }
+
+        static void deallocate(value_type* memory) noexcept
+        {
+            ::operator delete(static_cast<void*>(memory));
+        }
+
+        static void relocate(value_type* from, size_type n, value_type* to) noexcept
+        {
+            relocate_n(from, n, to);
+        }
+
+        size_type grown(size_type needed) const noexcept
+        {
+            return std::max(needed, storage ? storage * 2 : size_type(4));
+        }
+
+        void reallocate(size_type new_storage)
+        {
+            value_type* memory = allocate(new_storage);
+            relocate(first, count, memory);
+            deallocate(first);
+            first = memory;
+            storage = new_storage;
+        }
+
+        // Relocates a freshly constructed owner into slot `index`, opening a
+        // gap there first. Constructing before making room keeps arguments
+        // that refer to elements valid and leaves the vector untouched if
+        // the construction throws. Appending within capacity moves nothing
+        // and constructs in place.
+        template <typename... Args>
+        iterator place(size_type index, Args&&... args)
+        {
+            if (index == count && count < storage)
+            {
+                ::new (static_cast<void*>(first + count)) value_type(std::forward<Args>(args)...);
+                return first + count++;
+            }
+            alignas(value_type) unsigned char buffer[sizeof(value_type)];
+            auto* element = ::new (static_cast<void*>(buffer)) value_type(std::forward<Args>(args)...);
+            if (count == storage)
+            {
+                size_type new_storage = grown(count + 1);
+                value_type* memory;
+                try
+                {
+                    memory = allocate(new_storage);
+                }
+                catch (...)
+                {
+                    element->~value_type();
+                    throw;
+                }
+                relocate(first, index, memory);
+                relocate(first + index, count - index, memory + index + 1);
+                deallocate(first);
+                first = memory;
+                storage = new_storage;
+            }
+            else
+            {
+                relocate(first + index, count - index, first + index + 1);
+            }
+            relocate(element, 1, first + index);
+            ++count;
+            return first + index;
+        }
+
+    public:
+// constructors / destructor
+        linked_ptr_vector() noexcept : first(nullptr), count(0), storage(0) {}
+
+        linked_ptr_vector(linked_ptr_vector const& other) : linked_ptr_vector()
+        {
+            reserve(other.count);
+            for (auto const& owner : other)
+                push_back(owner);
+        }
+
+        linked_ptr_vector(linked_ptr_vector&& other) noexcept : first(other.first), count(other.count), storage(other.storage)
+        {
+            other.first = nullptr;
+            other.count = 0;
+            other.storage = 0;
+        }
+
+        ~linked_ptr_vector()
+        {
+            clear();
+            deallocate(first);
+        }
+
+// assign operators
+        linked_ptr_vector& operator=(linked_ptr_vector const& other)
+        {
+            linked_ptr_vector tmp(other);
+            swap(tmp);
+            return *this;
+        }
+
+        linked_ptr_vector& operator=(linked_ptr_vector&& other) noexcept
+        {
+            linked_ptr_vector tmp(std::move(other));
+            swap(tmp);
+            return *this;
+        }
+
+// element access
+        reference operator[](size_type index) noexcept
+        {
+            return first[index];
+        }
+
+        const_reference operator[](size_type index) const noexcept
+        {
+            return first[index];
+        }
+
+        reference front() noexcept
+        {
+            return first[0];
+        }
+
+        const_reference front() const noexcept
+        {
+            return first[0];
+        }
+
+        reference back() noexcept
+        {
+            return first[count - 1];
+        }
+
+        const_reference back() const noexcept
+        {
+            return first[count - 1];
+        }
+
+        value_type* data() noexcept
+        {
+            return first;
+        }
+
+        value_type const* data() const noexcept
+        {
+            return first;
+        }
+
+        iterator begin() noexcept
+        {
+            return first;
+        }
+
+        const_iterator begin() const noexcept
+        {
+            return first;
+        }
+
+        iterator end() noexcept
+        {
+            return first + count;
+        }
+
+        const_iterator end() const noexcept
+        {
+            return first + count;
+        }
+
+// capacity
+        bool empty() const noexcept
+        {
+            return count == 0;
+        }
+
+        size_type size() const noexcept
+        {
+            return count;
+        }
+
+        size_type capacity() const noexcept
+        {
+            return storage;
+        }
+
+        void reserve(size_type new_storage)
+        {
+            if (new_storage > storage)
+                reallocate(new_storage);
+        }
+
+        void shrink_to_fit()
+        {
+            if (count == 0)
+            {
+                deallocate(first);
+                first = nullptr;
+                storage = 0;
+            }
+            else if (count < storage)
+            {
+                reallocate(count);
+            }
+        }
+
+// modifiers
+        template <typename... Args>
+        reference emplace_back(Args&&... args)
+        {
+            return *place(count, std::forward<Args>(args)...);
+        }
+
+        void push_back(value_type const& owner)
+        {
+            place(count, owner);
+        }
+
+        void push_back(value_type&& owner)
+        {
+            place(count, std::move(owner));
+        }
+
+        template <typename... Args>
+        iterator emplace(const_iterator position, Args&&... args)
+        {
+            return place(static_cast<size_type>(position - first), std::forward<Args>(args)...);
+        }
+
+        iterator insert(const_iterator position, value_type const& owner)
+        {
+            return emplace(position, owner);
+        }
+
+        iterator insert(const_iterator position, value_type&& owner)
+        {
+            return emplace(position, std::move(owner));
+        }
+
+        void pop_back() noexcept
+        {
+            first[--count].~value_type();
+        }
+
+        iterator erase(const_iterator position) noexcept
+        {
+            return erase(position, position + 1);
+        }
+
+        iterator erase(const_iterator from, const_iterator to) noexcept
+        {
+            auto index = static_cast<size_type>(from - first);
+            auto erased = static_cast<size_type>(to - from);
+            destroy_range(first + index, first + index + erased);
+            relocate(first + index + erased, count - index - erased, first + index);
+            count -= erased;
+            return first + index;
+        }
+
+        void clear() noexcept
+        {
+            destroy_range(first, first + count);
+            count = 0;
+        }
+
+        void swap(linked_ptr_vector& other) noexcept
+        {
+            std::swap(first, other.first);
+            std::swap(count, other.count);
+            std::swap(storage, other.storage);
+        }
+    };
+
+    template <typename T, typename D>
+    void swap(linked_ptr_vector<T, D> &a, linked_ptr_vector<T, D> &b) noexcept
+    {
+        a.swap(b);
+    }
+}
+
+#endif
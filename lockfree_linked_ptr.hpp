@@ -0,0 +1,663 @@
+#ifndef LOCKFREE_LINKED_PTR_H
+#define LOCKFREE_LINKED_PTR_H
+
+#include "linked_ptr.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace smart_ptr
+{
+    namespace details
+    {
+        // Memory unlinked from a lock-free ring while other threads may
+        // still be walking over it. It is freed two epochs after being
+        // retired, when every thread inside a walk has started it since.
+        struct retirable
+        {
+            retirable* retired_next = nullptr;
+            std::uint64_t retired_epoch = 0;
+            void (*release)(retirable*) noexcept = nullptr;
+        };
+
+        struct epoch_record
+        {
+            // The epoch a thread entered at, shifted left; the low bit is
+            // set while it is inside.
+            std::atomic<std::uint64_t> announce{0};
+            std::atomic<bool> in_use{true};
+            epoch_record* next = nullptr;
+        };
+
+        // Trivially destructible, so it stays usable until the process ends.
+        // Spare links of exited threads, and those a thread's cache has no
+        // room for, are kept in `spare_links` and never freed.
+        struct epoch_domain
+        {
+            std::atomic<std::uint64_t> epoch{2};
+            std::atomic<epoch_record*> records{nullptr};
+            std::atomic<retirable*> orphans{nullptr};
+            std::atomic<retirable*> spare_links{nullptr};
+        };
+
+        inline epoch_domain& reclamation_domain() noexcept
+        {
+            static epoch_domain domain;
+            return domain;
+        }
+
+        // Per thread state; trivially destructible like the domain. The
+        // reaper hands what is left to the domain when the thread exits,
+        // later walks and retires go through the domain directly.
+        struct epoch_thread
+        {
+            epoch_record* record;
+            std::size_t nesting;
+            retirable* retired_head;
+            retirable* retired_tail;
+            std::size_t retired_count;
+            std::size_t collect_at;
+            retirable* spare_links;
+            std::size_t spare_count;
+            bool registered;
+            bool closed;
+        };
+
+        inline epoch_thread& this_epoch_thread() noexcept
+        {
+            thread_local epoch_thread state{nullptr, 0, nullptr, nullptr, 0, 64, nullptr, 0, false, false};
+            return state;
+        }
+
+        // Lists are only ever taken whole, so pushing needs no ABA guard.
+        inline void push_list(std::atomic<retirable*>& list, retirable* first, retirable* last) noexcept
+        {
+            retirable* head = list.load(std::memory_order_relaxed);
+            do
+            {
+                last->retired_next = head;
+            }
+            while (!list.compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        inline void adopt_orphans(retirable* first, retirable* last) noexcept
+        {
+            push_list(reclamation_domain().orphans, first, last);
+        }
+
+        inline epoch_record* acquire_record()
+        {
+            epoch_domain& domain = reclamation_domain();
+            for (epoch_record* r = domain.records.load(std::memory_order_acquire); r; r = r->next)
+            {
+                bool used = false;
+                if (!r->in_use.load(std::memory_order_relaxed) && r->in_use.compare_exchange_strong(used, true))
+                    return r;
+            }
+            auto* r = new epoch_record;
+            r->next = domain.records.load(std::memory_order_relaxed);
+            while (!domain.records.compare_exchange_weak(r->next, r, std::memory_order_release, std::memory_order_relaxed))
+            {
+            }
+            return r;
+        }
+
+        inline void release_record(epoch_thread& thread) noexcept
+        {
+            thread.record->announce.store(0, std::memory_order_release);
+            thread.record->in_use.store(false, std::memory_order_release);
+            thread.record = nullptr;
+        }
+
+        struct epoch_reaper
+        {
+            ~epoch_reaper()
+            {
+                epoch_thread& thread = this_epoch_thread();
+                if (thread.retired_head)
+                    adopt_orphans(thread.retired_head, thread.retired_tail);
+                thread.retired_head = thread.retired_tail = nullptr;
+                thread.retired_count = 0;
+                if (retirable* first = thread.spare_links)
+                {
+                    retirable* last = first;
+                    while (last->retired_next)
+                        last = last->retired_next;
+                    push_list(reclamation_domain().spare_links, first, last);
+                }
+                thread.spare_links = nullptr;
+                thread.spare_count = 0;
+                if (thread.record && thread.nesting == 0)
+                    release_record(thread);
+                thread.closed = true;
+            }
+        };
+
+        inline void epoch_enter() noexcept
+        {
+            epoch_thread& thread = this_epoch_thread();
+            if (thread.nesting++ != 0)
+                return;
+            if (!thread.record)
+            {
+                thread.record = acquire_record();
+                if (!thread.registered)
+                {
+                    thread_local epoch_reaper reaper;
+                    (void) reaper;
+                    thread.registered = true;
+                }
+            }
+            std::uint64_t epoch = reclamation_domain().epoch.load();
+            thread.record->announce.store(epoch << 1 | 1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+
+        inline void epoch_exit() noexcept
+        {
+            epoch_thread& thread = this_epoch_thread();
+            if (--thread.nesting != 0)
+                return;
+            if (thread.closed)
+                release_record(thread);
+            else
+                thread.record->announce.store(0, std::memory_order_release);
+        }
+
+        inline void try_advance_epoch() noexcept
+        {
+            epoch_domain& domain = reclamation_domain();
+            std::uint64_t epoch = domain.epoch.load();
+            for (epoch_record* r = domain.records.load(std::memory_order_acquire); r; r = r->next)
+            {
+                std::uint64_t announced = r->announce.load();
+                if ((announced & 1) && (announced >> 1) != epoch)
+                    return;
+            }
+            domain.epoch.compare_exchange_strong(epoch, epoch + 1);
+        }
+
+        inline void collect_retired(epoch_thread& thread) noexcept
+        {
+            epoch_domain& domain = reclamation_domain();
+            if (retirable* adopted = domain.orphans.exchange(nullptr, std::memory_order_acquire))
+            {
+                if (thread.retired_tail)
+                    thread.retired_tail->retired_next = adopted;
+                else
+                    thread.retired_head = adopted;
+                for (; adopted; adopted = adopted->retired_next)
+                {
+                    thread.retired_tail = adopted;
+                    ++thread.retired_count;
+                }
+            }
+            try_advance_epoch();
+            std::uint64_t epoch = domain.epoch.load();
+            // Stops at the first entry still in use; adopted entries may be
+            // older than it and wait a little longer.
+            while (thread.retired_head && thread.retired_head->retired_epoch + 2 <= epoch)
+            {
+                retirable* done = thread.retired_head;
+                thread.retired_head = done->retired_next;
+                --thread.retired_count;
+                done->release(done);
+            }
+            if (!thread.retired_head)
+                thread.retired_tail = nullptr;
+            thread.collect_at = thread.retired_count + 64;
+        }
+
+        inline void retire(retirable* unlinked) noexcept
+        {
+            epoch_thread& thread = this_epoch_thread();
+            unlinked->retired_next = nullptr;
+            unlinked->retired_epoch = reclamation_domain().epoch.load();
+            if (thread.closed)
+            {
+                adopt_orphans(unlinked, unlinked);
+                return;
+            }
+            if (thread.retired_tail)
+                thread.retired_tail->retired_next = unlinked;
+            else
+                thread.retired_head = unlinked;
+            thread.retired_tail = unlinked;
+            if (++thread.retired_count >= thread.collect_at)
+                collect_retired(thread);
+        }
+
+        std::uintptr_t const removed_link = 1;
+
+        // Start of a lock-free ring: `first` is its first link, or just
+        // removed_link once the last one is gone and the object destroyed.
+        class lockfree_ring : public retirable
+        {
+        public:
+            std::atomic<std::uintptr_t> first{0};
+
+            lockfree_ring() noexcept
+            {
+                release = &free_ring;
+            }
+
+            lockfree_ring(lockfree_ring const&) = delete;
+            lockfree_ring& operator=(lockfree_ring const&) = delete;
+
+            virtual void destroy_object() noexcept = 0;
+
+            // For a ring that never had a link.
+            static void free(lockfree_ring* ring) noexcept
+            {
+                delete ring;
+            }
+
+        protected:
+            virtual ~lockfree_ring() = default;
+
+        private:
+            static void free_ring(retirable* ring) noexcept
+            {
+                delete static_cast<lockfree_ring*>(ring);
+            }
+        };
+
+        template <typename T, typename D>
+        class lockfree_pointer_header final : public lockfree_ring, private deleter_holder<D>
+        {
+        private:
+            T* pointer;
+
+        public:
+            lockfree_pointer_header(T* pointer, D deleter) : deleter_holder<D>(std::move(deleter)), pointer(pointer) {}
+
+        private:
+            void destroy_object() noexcept override
+            {
+                this->deleter()(pointer);
+            }
+        };
+
+        // One owner's place in the ring. The low bit of `next` marks a link
+        // whose owner is going away; a marked link is never linked again.
+        // `previous` is a hint at the link before it, null for the first
+        // one, and may be stale. Links are recycled but never freed, so a
+        // stale hint still points at a link; it is trusted only while that
+        // link is published and points at this one.
+        struct alignas(2) ring_link : retirable
+        {
+            std::atomic<std::uintptr_t> next;
+            std::atomic<ring_link*> previous{nullptr};
+            std::atomic<bool> published{false};
+            lockfree_ring* ring;
+
+            ring_link(lockfree_ring* ring, std::uintptr_t next) noexcept : next(next), ring(ring)
+            {
+                release = &free_link;
+            }
+
+            // Links are taken from the cache of the thread, refilled from
+            // the domain's spares, since every copy needs one. A recycled
+            // link is unpublished before its new `next` is visible.
+            static ring_link* create(lockfree_ring* ring, std::uintptr_t next)
+            {
+                epoch_thread& thread = this_epoch_thread();
+                if (!thread.spare_links && !thread.closed)
+                {
+                    retirable* taken = reclamation_domain().spare_links.exchange(nullptr, std::memory_order_acquire);
+                    thread.spare_links = taken;
+                    for (; taken; taken = taken->retired_next)
+                        ++thread.spare_count;
+                }
+                retirable* spare = thread.closed ? nullptr : thread.spare_links;
+                if (!spare)
+                    return new ring_link(ring, next);
+                thread.spare_links = spare->retired_next;
+                --thread.spare_count;
+                auto* link = static_cast<ring_link*>(spare);
+                link->published.store(false, std::memory_order_relaxed);
+                link->previous.store(nullptr, std::memory_order_relaxed);
+                link->ring = ring;
+                link->next.store(next, std::memory_order_release);
+                return link;
+            }
+
+            static void free_link(retirable* link) noexcept
+            {
+                epoch_thread& thread = this_epoch_thread();
+                if (thread.closed || thread.spare_count >= 64)
+                {
+                    push_list(reclamation_domain().spare_links, link, link);
+                    return;
+                }
+                link->retired_next = thread.spare_links;
+                thread.spare_links = link;
+                ++thread.spare_count;
+            }
+        };
+
+        // Links a new owner right after `source`, whose owner is alive and
+        // stays so meanwhile; only a neighbour being unlinked can race.
+        inline ring_link* link_after(ring_link* source)
+        {
+            ring_link* link = ring_link::create(source->ring, 0);
+            link->previous.store(source, std::memory_order_relaxed);
+            std::uintptr_t next = source->next.load(std::memory_order_relaxed);
+            do
+            {
+                link->next.store(next, std::memory_order_release);
+            }
+            while (!source->next.compare_exchange_weak(next, reinterpret_cast<std::uintptr_t>(link),
+                                                       std::memory_order_acq_rel, std::memory_order_relaxed));
+            link->published.store(true, std::memory_order_release);
+            if (next)
+                reinterpret_cast<ring_link*>(next)->previous.store(link, std::memory_order_relaxed);
+            return link;
+        }
+
+        // Called by whoever unlinked `link` from after `previous`.
+        inline void finish_unlink(ring_link* link, ring_link* previous, std::uintptr_t successor) noexcept
+        {
+            link->published.store(false, std::memory_order_release);
+            if (successor)
+                reinterpret_cast<ring_link*>(successor)->previous.store(previous, std::memory_order_relaxed);
+            retire(link);
+        }
+
+        // Unlinks the marked `link`, followed by `successor`, with one CAS
+        // on the link its hint points at. With `help`, a marked link there
+        // is unlinked first through its own hint. False if a hint is stale.
+        // A link seen published is not recycled before epoch_exit, since
+        // it is unpublished before it is retired.
+        inline bool unlink_from_hint(lockfree_ring* ring, ring_link* link, std::uintptr_t successor, bool help) noexcept
+        {
+            auto address = reinterpret_cast<std::uintptr_t>(link);
+            ring_link* previous = link->previous.load(std::memory_order_acquire);
+            std::atomic<std::uintptr_t>* field = &ring->first;
+            if (previous)
+            {
+                std::uintptr_t seen = previous->next.load(std::memory_order_acquire);
+                if (!previous->published.load(std::memory_order_acquire))
+                    return false;
+                if (seen == (address | removed_link) && help)
+                    return unlink_from_hint(ring, previous, address, false) &&
+                           unlink_from_hint(ring, link, successor, false);
+                if (seen != address)
+                    return false;
+                field = &previous->next;
+            }
+            if (!field->compare_exchange_strong(address, successor, std::memory_order_acq_rel, std::memory_order_relaxed))
+                return false;
+            finish_unlink(link, previous, successor);
+            return true;
+        }
+
+        // Walks the ring from its start and unlinks every marked link met;
+        // restarts whenever a predecessor got marked under it. Returns
+        // false if the ring turned out closed.
+        inline bool unlink_marked(lockfree_ring* ring) noexcept
+        {
+        restart:
+            std::atomic<std::uintptr_t>* previous = &ring->first;
+            ring_link* previous_link = nullptr;
+            std::uintptr_t current = previous->load(std::memory_order_acquire);
+            for (;;)
+            {
+                if (current & removed_link)
+                {
+                    if (previous == &ring->first)
+                        return false;
+                    goto restart;
+                }
+                if (!current)
+                    return true;
+                auto* link = reinterpret_cast<ring_link*>(current);
+                std::uintptr_t next = link->next.load(std::memory_order_acquire);
+                if (next & removed_link)
+                {
+                    std::uintptr_t expected = current;
+                    if (!previous->compare_exchange_strong(expected, next & ~removed_link, std::memory_order_acq_rel))
+                        goto restart;
+                    finish_unlink(link, previous_link, next & ~removed_link);
+                    current = next & ~removed_link;
+                }
+                else
+                {
+                    previous = &link->next;
+                    previous_link = link;
+                    current = next;
+                }
+            }
+        }
+
+        // Marks `link` and makes sure it is unlinked: through its hint in
+        // constant time, unless a neighbour did it meanwhile or the hint
+        // stays stale, and by a walk from the start of the ring otherwise.
+        // The thread that finds the ring empty afterwards closes it and
+        // destroys the object; no new link can appear then, since links
+        // are only added next to a live one.
+        inline void unlink(ring_link* link) noexcept
+        {
+            lockfree_ring* ring = link->ring;
+            epoch_enter();
+            std::uintptr_t next = link->next.load(std::memory_order_relaxed);
+            while (!link->next.compare_exchange_weak(next, next | removed_link, std::memory_order_acq_rel, std::memory_order_relaxed))
+            {
+            }
+            bool open = false;
+            for (int attempt = 0; attempt < 4 && !open; ++attempt)
+                open = !link->published.load(std::memory_order_acquire) || unlink_from_hint(ring, link, next, true);
+            if (!open)
+                open = unlink_marked(ring);
+            bool last = false;
+            if (open)
+            {
+                std::uintptr_t empty = 0;
+                last = ring->first.compare_exchange_strong(empty, removed_link, std::memory_order_acq_rel);
+            }
+            epoch_exit();
+            if (last)
+            {
+                ring->destroy_object();
+                retire(ring);
+            }
+        }
+
+        inline std::size_t count_links(lockfree_ring* ring) noexcept
+        {
+            epoch_enter();
+            std::size_t count = 0;
+            std::uintptr_t current = ring->first.load(std::memory_order_acquire);
+            while (current && !(current & removed_link))
+            {
+                auto* link = reinterpret_cast<ring_link*>(current);
+                std::uintptr_t next = link->next.load(std::memory_order_acquire);
+                if (!(next & removed_link))
+                    ++count;
+                current = next & ~removed_link;
+            }
+            epoch_exit();
+            return count;
+        }
+    }
+
+    // Owners of one object may be copied and destroyed from different
+    // threads without ever waiting on each other. Every owner has a link
+    // of its own in a singly linked ring. Copying links a new one after
+    // the source's with one CAS. Releasing marks the owner's link and
+    // unlinks it from the link before it, found through a hint kept up to
+    // date by copies and releases; only when neighbours keep changing
+    // under it does it walk the ring from its start.
+    //
+    // The links, unlike the owners of linked_ptr, are allocated on the
+    // heap: a neighbour may still be reading a link that was just
+    // unlinked, so links are recycled through epochs once no walk can
+    // reach them. They are never freed, which keeps stale hints safe.
+    template <typename T>
+    class lockfree_linked_ptr
+    {
+        template <typename U>
+        friend class lockfree_linked_ptr;
+
+    private:
+        details::ring_link* link;
+        T* pointer;
+
+    public:
+        using element_type = T;
+
+// constructors / destructor
+        constexpr lockfree_linked_ptr() noexcept : link(nullptr), pointer(nullptr) {}
+
+        template <typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+        explicit lockfree_linked_ptr(U* pointer) : lockfree_linked_ptr(pointer, default_delete<U>()) {}
+
+        template <typename U, typename D, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+        lockfree_linked_ptr(U* pointer, D deleter) : link(nullptr), pointer(pointer)
+        {
+            if (!pointer)
+                return;
+            details::lockfree_ring* ring = nullptr;
+            try
+            {
+                ring = new details::lockfree_pointer_header<U, D>(pointer, deleter);
+                link = details::ring_link::create(ring, 0);
+                link->published.store(true, std::memory_order_relaxed);
+            }
+            catch (...)
+            {
+                if (ring)
+                    details::lockfree_ring::free(ring);
+                deleter(pointer);
+                throw;
+            }
+            ring->first.store(reinterpret_cast<std::uintptr_t>(link), std::memory_order_release);
+        }
+
+        lockfree_linked_ptr(lockfree_linked_ptr const& other)
+            : link(other.link ? details::link_after(other.link) : nullptr), pointer(other.pointer) {}
+
+        lockfree_linked_ptr(lockfree_linked_ptr&& other) noexcept : link(other.link), pointer(other.pointer)
+        {
+            other.link = nullptr;
+            other.pointer = nullptr;
+        }
+
+        template <typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+        lockfree_linked_ptr(lockfree_linked_ptr<U> const& other)
+            : link(other.link ? details::link_after(other.link) : nullptr), pointer(other.pointer) {}
+
+        template <typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+        lockfree_linked_ptr(lockfree_linked_ptr<U>&& other) noexcept : link(other.link), pointer(other.pointer)
+        {
+            other.link = nullptr;
+            other.pointer = nullptr;
+        }
+
+        ~lockfree_linked_ptr()
+        {
+            destroy();
+        }
+
+// assign operators
+        lockfree_linked_ptr& operator=(lockfree_linked_ptr const& other)
+        {
+            lockfree_linked_ptr tmp(other);
+            swap(tmp);
+            return *this;
+        }
+
+        lockfree_linked_ptr& operator=(lockfree_linked_ptr&& other) noexcept
+        {
+            lockfree_linked_ptr tmp(std::move(other));
+            swap(tmp);
+            return *this;
+        }
+
+// common smart pointer interface
+        template <typename U = T, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+        void reset(U* new_pointer = nullptr)
+        {
+            lockfree_linked_ptr tmp(new_pointer);
+            swap(tmp);
+        }
+
+        void swap(lockfree_linked_ptr& other) noexcept
+        {
+            std::swap(link, other.link);
+            std::swap(pointer, other.pointer);
+        }
+
+        T* get() const noexcept
+        {
+            return pointer;
+        }
+
+        bool unique() const noexcept
+        {
+            return pointer && use_count() == 1;
+        }
+
+        // Walks the ring; only a snapshot while other threads copy or
+        // release owners of the object.
+        std::size_t use_count() const noexcept
+        {
+            return link ? details::count_links(link->ring) : 0;
+        }
+
+        operator bool() const noexcept
+        {
+            return get();
+        }
+
+// pointer using interface
+        T& operator*() const
+        {
+            return *get();
+        }
+
+        T* operator->() const
+        {
+            return get();
+        }
+
+    private:
+        void destroy() noexcept
+        {
+            if (link)
+                details::unlink(link);
+            link = nullptr;
+            pointer = nullptr;
+        }
+    };
+
+    template <typename T, typename U>
+    inline bool operator==(lockfree_linked_ptr<T> const& a, lockfree_linked_ptr<U> const& b) noexcept
+    {
+        return a.get() == b.get();
+    }
+
+    template <typename T, typename U>
+    inline bool operator!=(lockfree_linked_ptr<T> const& a, lockfree_linked_ptr<U> const& b) noexcept
+    {
+        return !(a == b);
+    }
+
+    template <typename T, typename U>
+    inline bool operator<(lockfree_linked_ptr<T> const& a, lockfree_linked_ptr<U> const& b) noexcept
+    {
+        return a.get() < b.get();
+    }
+
+    template <typename T>
+    void swap(lockfree_linked_ptr<T> &a, lockfree_linked_ptr<T> &b) noexcept
+    {
+        a.swap(b);
+    }
+}
+
+#endif
@@ -1,7 +1,23 @@
 #include "gtest.h"
 #include "linked_ptr.hpp"
+#include "atomic_linked_ptr.hpp"
+#include "concurrent_linked_ptr.hpp"
+#include "linked_ptr_algorithm.hpp"
+#include "linked_ptr_pool.hpp"
+#include "linked_ptr_reclaimer.hpp"
+#include "linked_ptr_region.hpp"
+#include "linked_ptr_vector.hpp"
+#include "lockfree_linked_ptr.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <memory_resource>
 #include <set>
+#include <thread>
+#include <unordered_set>
+#include <vector>
 
 using namespace smart_ptr;
 
@@ -126,6 +142,402 @@ TEST(copying, destruction_after_assign_correctness)
     ASSERT_EQ(count, 1);
 }
 
+TEST(moving, constructor)
+{
+    int count = 0;
+    {
+        linked_ptr<DestructionDetector> x(new DestructionDetector(&count));
+        linked_ptr<DestructionDetector> y(x);
+        linked_ptr<DestructionDetector> z(std::move(x));
+        ASSERT_FALSE(x);
+        ASSERT_EQ(y, z);
+        ASSERT_FALSE(y.unique());
+        y.reset();
+        ASSERT_TRUE(z.unique());
+        ASSERT_EQ(count, 0);
+    }
+    ASSERT_EQ(count, 1);
+}
+
+TEST(moving, assign)
+{
+    int count = 0;
+    {
+        linked_ptr<DestructionDetector> x(new DestructionDetector(&count));
+        linked_ptr<DestructionDetector> y(new DestructionDetector(&count));
+        linked_ptr<DestructionDetector> z(y);
+        y = std::move(x);
+        ASSERT_FALSE(x);
+        ASSERT_TRUE(y.unique());
+        ASSERT_TRUE(z.unique());
+        z = std::move(y);
+        ASSERT_EQ(count, 1);
+        z = std::move(z);
+        ASSERT_TRUE(z.unique());
+    }
+    ASSERT_EQ(count, 2);
+}
+
+TEST(moving, base_derived)
+{
+    linked_ptr<Derived> x(new Derived(5, 6));
+    linked_ptr<Derived> y(x);
+    linked_ptr<Base> z(std::move(x));
+    ASSERT_FALSE(x);
+    ASSERT_EQ(z->result(), 6);
+    y.reset();
+    ASSERT_TRUE(z.unique());
+}
+
+TEST(moving, vector_growth)
+{
+    int count = 0;
+    {
+        std::vector<linked_ptr<DestructionDetector>> v;
+        linked_ptr<DestructionDetector> x(new DestructionDetector(&count));
+        for (int i = 0; i < 100; ++i)
+            v.push_back(x);
+        x.reset();
+        v.erase(v.begin(), v.begin() + 99);
+        ASSERT_TRUE(v.back().unique());
+        ASSERT_EQ(count, 0);
+    }
+    ASSERT_EQ(count, 1);
+    static_assert(std::is_nothrow_move_constructible_v<linked_ptr<int>>);
+    static_assert(std::is_nothrow_move_assignable_v<linked_ptr<int>>);
+}
+
+TEST(make_linked, construct)
+{
+    linked_ptr<std::pair<int, int>> x = make_linked<std::pair<int, int>>(2, 4);
+    ASSERT_EQ(x->first, 2);
+    ASSERT_EQ(x->second, 4);
+    ASSERT_TRUE(x.unique());
+}
+
+TEST(make_linked, destruction_correctness)
+{
+    int count = 0;
+    {
+        auto x = make_linked<DestructionDetector>(&count);
+        {
+            linked_ptr<DestructionDetector> y(x);
+            linked_ptr<DestructionDetector> z(std::move(x));
+            ASSERT_FALSE(y.unique());
+            ASSERT_FALSE(z.unique());
+            x = y;
+        }
+        ASSERT_TRUE(x.unique());
+        ASSERT_EQ(count, 0);
+    }
+    ASSERT_EQ(count, 1);
+}
+
+TEST(make_linked, swap_and_reset)
+{
+    int count = 0;
+    {
+        auto x = make_linked<DestructionDetector>(&count);
+        linked_ptr<DestructionDetector> y(new DestructionDetector(&count));
+        linked_ptr<DestructionDetector> z(x);
+        swap(x, y);
+        ASSERT_TRUE(x.unique());
+        ASSERT_FALSE(y.unique());
+        z.reset();
+        ASSERT_TRUE(y.unique());
+        y.reset();
+        ASSERT_EQ(count, 1);
+    }
+    ASSERT_EQ(count, 2);
+}
+
+TEST(make_linked, base_derived)
+{
+    linked_ptr<Base> x = make_linked<Derived>(5, 6);
+    ASSERT_EQ(x->result(), 6);
+}
+
+TEST(make_linked, for_overwrite)
+{
+    auto x = make_linked_for_overwrite<std::pair<int, int>>();
+    x->first = 7;
+    ASSERT_EQ(x->first, 7);
+}
+
+struct alignas(64) OverAligned
+{
+    char data[64];
+};
+
+TEST(make_linked, alignment)
+{
+    auto x = make_linked<OverAligned>();
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(x.get()) % 64, 0u);
+}
+
+template <typename T>
+struct CountingAllocator
+{
+    using value_type = T;
+
+    int* allocations;
+
+    explicit CountingAllocator(int* allocations) : allocations(allocations) {}
+
+    template <typename U>
+    CountingAllocator(CountingAllocator<U> const& other) : allocations(other.allocations) {}
+
+    T* allocate(std::size_t n)
+    {
+        (*allocations)++;
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* pointer, std::size_t n)
+    {
+        (*allocations)--;
+        std::allocator<T>().deallocate(pointer, n);
+    }
+};
+
+TEST(allocate_linked, allocator)
+{
+    int allocations = 0;
+    int count = 0;
+    {
+        auto x = allocate_linked<DestructionDetector>(CountingAllocator<int>(&allocations), &count);
+        linked_ptr<DestructionDetector> y(x);
+        ASSERT_EQ(allocations, 1);
+        x.reset();
+        ASSERT_EQ(count, 0);
+    }
+    ASSERT_EQ(count, 1);
+    ASSERT_EQ(allocations, 0);
+}
+
+TEST(allocate_linked, pmr)
+{
+    char buffer[1024];
+    std::pmr::monotonic_buffer_resource resource(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+    auto x = pmr::allocate_linked<std::pmr::vector<int>>(&resource, 3, 7);
+    ASSERT_GE(reinterpret_cast<char*>(x.get()), buffer);
+    ASSERT_LT(reinterpret_cast<char*>(x.get()), buffer + sizeof(buffer));
+    ASSERT_EQ(x->get_allocator().resource(), &resource);
+    ASSERT_EQ((*x)[2], 7);
+}
+
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+    int allocations = 0;
+    int deallocations = 0;
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        ++allocations;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+    {
+        ++deallocations;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+TEST(region, bulk_free_on_last_release)
+{
+    CountingResource upstream;
+    int count = 0;
+    linked_ptr<DestructionDetector> survivor;
+    {
+        linked_region region(256, &upstream);
+        for (int i = 0; i < 100; ++i)
+        {
+            auto x = region.make<DestructionDetector>(&count);
+            linked_ptr<DestructionDetector> y(x);
+        }
+        ASSERT_EQ(count, 100);
+        survivor = region.make<DestructionDetector>(&count);
+    }
+    ASSERT_GT(upstream.allocations, 1);
+    ASSERT_EQ(upstream.deallocations, 0);
+    survivor.reset();
+    ASSERT_EQ(count, 101);
+    ASSERT_EQ(upstream.deallocations, upstream.allocations);
+}
+
+struct RegionNode
+{
+    linked_ptr<RegionNode> next;
+    std::pmr::vector<int> values;
+
+    explicit RegionNode(std::pmr::memory_resource* resource) : values(3, 7, resource) {}
+};
+
+TEST(region, graph_with_weak_observer)
+{
+    CountingResource upstream;
+    weak_linked_ptr<RegionNode> tail;
+    {
+        linked_region region(1024, &upstream);
+        auto head = region.make<RegionNode>(region.resource());
+        head->next = region.make<RegionNode>(region.resource());
+        head->next->next = region.make<RegionNode>(region.resource());
+        tail = head->next->next;
+        ASSERT_EQ(tail.lock()->values[2], 7);
+        ASSERT_EQ(upstream.allocations, 1);
+    }
+    ASSERT_TRUE(tail.expired());
+    ASSERT_EQ(upstream.deallocations, 0);
+    tail.reset();
+    ASSERT_EQ(upstream.deallocations, 1);
+}
+
+struct PooledMessage
+{
+    int value;
+    int* cnt;
+
+    PooledMessage(int value, int* counter) : value(value), cnt(counter) {}
+
+    ~PooledMessage()
+    {
+        (*cnt)++;
+    }
+};
+
+namespace smart_ptr
+{
+    template <>
+    struct linked_ptr_traits<PooledMessage>
+    {
+        static constexpr std::size_t promotion_threshold = 0;
+        static constexpr bool demote = true;
+        static constexpr std::size_t pool_high_water_mark = 2;
+    };
+}
+
+TEST(pool, recycles_blocks)
+{
+    linked_pool<PooledMessage>::trim();
+    int count = 0;
+    auto x = linked_pool<PooledMessage>::make(1, &count);
+    linked_ptr<PooledMessage> y(x);
+    PooledMessage* first = x.get();
+    x.reset();
+    y.reset();
+    ASSERT_EQ(count, 1);
+    ASSERT_EQ(linked_pool<PooledMessage>::cached(), 1u);
+    auto z = linked_pool<PooledMessage>::make(2, &count);
+    ASSERT_EQ(z.get(), first);
+    ASSERT_EQ(z->value, 2);
+    ASSERT_EQ(linked_pool<PooledMessage>::cached(), 0u);
+}
+
+TEST(pool, high_water_mark)
+{
+    int count = 0;
+    {
+        std::vector<linked_ptr<PooledMessage>> messages;
+        for (int i = 0; i < 5; ++i)
+            messages.push_back(linked_pool<PooledMessage>::make(i, &count));
+    }
+    ASSERT_EQ(count, 5);
+    ASSERT_EQ(linked_pool<PooledMessage>::cached(), 2u);
+    std::thread other([]
+    {
+        int ignored = 0;
+        linked_pool<PooledMessage>::make(0, &ignored);
+        ASSERT_EQ(linked_pool<PooledMessage>::cached(), 1u);
+    });
+    other.join();
+    ASSERT_EQ(linked_pool<PooledMessage>::cached(), 2u);
+    linked_pool<PooledMessage>::trim();
+    ASSERT_EQ(linked_pool<PooledMessage>::cached(), 0u);
+}
+
+TEST(pool, weak_observer_keeps_block)
+{
+    int count = 0;
+    linked_pool<PooledMessage>::trim();
+    weak_linked_ptr<PooledMessage> w = linked_pool<PooledMessage>::make(0, &count);
+    ASSERT_TRUE(w.expired());
+    ASSERT_EQ(count, 1);
+    ASSERT_EQ(linked_pool<PooledMessage>::cached(), 0u);
+    w.reset();
+    ASSERT_EQ(linked_pool<PooledMessage>::cached(), 1u);
+}
+
+struct CountingDeleter
+{
+    int* cnt;
+
+    void operator()(int* pointer) const
+    {
+        (*cnt)++;
+        delete pointer;
+    }
+};
+
+struct StatelessDeleter
+{
+    void operator()(int* pointer) const
+    {
+        delete pointer;
+    }
+};
+
+TEST(deleter, custom)
+{
+    int count = 0;
+    {
+        linked_ptr<int, CountingDeleter> x(new int(5), CountingDeleter{&count});
+        linked_ptr<int, CountingDeleter> y(x);
+        x.reset();
+        ASSERT_EQ(count, 0);
+        ASSERT_EQ(y.get_deleter().cnt, &count);
+    }
+    ASSERT_EQ(count, 1);
+}
+
+TEST(deleter, reset_with_deleter)
+{
+    int count = 0;
+    linked_ptr<int, CountingDeleter> x(new int(5), CountingDeleter{&count});
+    x.reset(new int(6), CountingDeleter{&count});
+    ASSERT_EQ(count, 1);
+    x.reset();
+    ASSERT_EQ(count, 2);
+}
+
+TEST(deleter, function_pointer)
+{
+    static int count;
+    count = 0;
+    void (*release)(int*) = [](int* pointer) { count++; delete pointer; };
+    {
+        linked_ptr<int, void (*)(int*)> x(new int(5), release);
+        auto y = std::move(x);
+        ASSERT_EQ(count, 0);
+    }
+    ASSERT_EQ(count, 1);
+}
+
+TEST(deleter, size)
+{
+    static_assert(sizeof(linked_ptr<int>) == 3 * sizeof(void*));
+    static_assert(sizeof(linked_ptr<int, StatelessDeleter>) == 3 * sizeof(void*));
+    static_assert(sizeof(linked_ptr<int, CountingDeleter>) == 4 * sizeof(void*));
+    SUCCEED();
+}
+
 TEST(common_interface, bool_operator)
 {
     linked_ptr<int> x(new int(5));
@@ -158,6 +570,20 @@ TEST(common_interface, swap)
     ASSERT_TRUE(y);
 }
 
+TEST(common_interface, swap_same_ring)
+{
+    linked_ptr<int> x(new int(5));
+    linked_ptr<int> y(x), z(x);
+    swap(x, y);
+    swap(y, z);
+    x.swap(x);
+    ASSERT_EQ(x.use_count(), 3u);
+    ASSERT_EQ(z.use_count(), 3u);
+    z.reset();
+    y.reset();
+    ASSERT_TRUE(x.unique());
+}
+
 TEST(common_interface, swap_base_derived)
 {
     linked_ptr<Base> y(new Base(5)), x(new Derived(5, 6));
@@ -205,51 +631,1368 @@ TEST(common_interface, unique)
     ASSERT_TRUE(x.unique());
 }
 
-TEST(pointer_using_interface, arrow)
+TEST(owners, use_count)
 {
-    linked_ptr<std::pair<int, int> > x(new std::pair<int, int>(2, 4));
-    ASSERT_EQ(x->first, 2);
-    ASSERT_EQ(x->second, 4);
+    linked_ptr<int> empty;
+    ASSERT_EQ(empty.use_count(), 0u);
+
+    linked_ptr<int> x(new int(5));
+    ASSERT_EQ(x.use_count(), 1u);
+    std::vector<linked_ptr<int>> v(10, x);
+    ASSERT_EQ(x.use_count(), 11u);
+    ASSERT_EQ(v[4].use_count(), 11u);
+    v.resize(3);
+    ASSERT_EQ(v[1].use_count(), 4u);
+
+    auto y = make_linked<int>(6);
+    linked_ptr<int> z(y), w(z);
+    ASSERT_EQ(y.use_count(), 3u);
+    ASSERT_EQ(w.use_count(), 3u);
 }
 
-TEST(pointer_using_interface, star)
+TEST(owners, for_each_owner)
 {
-    int * x = new int(5);
-    linked_ptr<int> y(x);
-    ASSERT_EQ(*y, 5);
+    auto x = make_linked<int>(5);
+    linked_ptr<int> y(x), z(y);
+    std::set<void const*> seen;
+    z.for_each_owner([&](void const* owner) { seen.insert(owner); });
+    ASSERT_EQ(seen.size(), 3u);
+    ASSERT_EQ(seen.count(x.owner_id()), 1u);
+    ASSERT_EQ(seen.count(y.owner_id()), 1u);
+    ASSERT_EQ(seen.count(z.owner_id()), 1u);
 }
 
-TEST(comparison, eq)
+TEST(owners, range)
 {
-    int * x = new int(5);
-    linked_ptr<int> y(x);
-    linked_ptr<int> z(y);
-    ASSERT_TRUE(y == z);
-    ASSERT_FALSE(y != z);
+    linked_ptr<int> x(new int(5));
+    linked_ptr<int> y(x), z(x);
+    std::vector<void const*> ids(y.owners().begin(), y.owners().end());
+    ASSERT_EQ(ids.size(), 3u);
+    ASSERT_EQ(std::distance(z.owners().begin(), z.owners().end()), 3);
+    ASSERT_EQ(std::set<void const*>(ids.begin(), ids.end()).size(), 3u);
+}
 
-    y.reset(new int(6));
-    ASSERT_FALSE(y == z);
-    ASSERT_TRUE(y != z);
+struct Snapshot
+{
+    int* cnt;
+
+    ~Snapshot()
+    {
+        (*cnt)++;
+    }
+};
+
+namespace smart_ptr
+{
+    template <>
+    struct linked_ptr_traits<Snapshot>
+    {
+        static constexpr std::size_t promotion_threshold = 4;
+        static constexpr bool demote = true;
+    };
 }
 
-TEST(comparison, set)
+TEST(promotion, counted)
 {
-    std::set<linked_ptr<int> > q;
-    q.insert(linked_ptr<int>(new int(5)));
-    q.insert(linked_ptr<int>(new int(5)));
-    q.insert(linked_ptr<int>(new int(6)));
-    q.insert(linked_ptr<int>(*q.begin()));
-    ASSERT_EQ(q.size(), 3);
+    int count = 0;
+    {
+        linked_ptr<Snapshot> x(new Snapshot{&count});
+        std::vector<linked_ptr<Snapshot>> v;
+        v.reserve(100);
+        for (int i = 0; i < 100; ++i)
+            v.push_back(x);
+        ASSERT_EQ(x.use_count(), 101u);
+        ASSERT_EQ(v[50].use_count(), 101u);
+        ASSERT_FALSE(v[50].unique());
+        v.erase(v.begin(), v.begin() + 60);
+        ASSERT_EQ(x.use_count(), 41u);
+        linked_ptr<Snapshot> moved(std::move(v.back()));
+        v.pop_back();
+        swap(moved, v.front());
+        ASSERT_EQ(moved.use_count(), 41u);
+        v.clear();
+        ASSERT_EQ(moved.use_count(), 2u);
+        moved.reset();
+        ASSERT_TRUE(x.unique());
+        ASSERT_EQ(count, 0);
+    }
+    ASSERT_EQ(count, 1);
 }
 
-TEST(comparison, set_greater)
+TEST(promotion, demote)
 {
-    std::set<linked_ptr<int>, std::greater<linked_ptr<int>> > q;
-    q.insert(linked_ptr<int>(new int(5)));
-    q.insert(linked_ptr<int>(new int(5)));
-    q.insert(linked_ptr<int>(new int(6)));
-    q.insert(linked_ptr<int>(*q.begin()));
-    ASSERT_EQ(q.size(), 3);
+    int count = 0;
+    {
+        auto x = make_linked<Snapshot>(Snapshot{&count});
+        count = 0;
+        {
+            std::vector<linked_ptr<Snapshot>> v(10, x);
+            ASSERT_EQ(x.use_count(), 11u);
+        }
+        ASSERT_TRUE(x.unique());
+        linked_ptr<Snapshot> y(x);
+        ASSERT_EQ(y.use_count(), 2u);
+        ASSERT_EQ(std::distance(y.owners().begin(), y.owners().end()), 2);
+        y.reset();
+        ASSERT_EQ(count, 0);
+    }
+    ASSERT_EQ(count, 1);
+}
+
+TEST(promotion, mixed_types)
+{
+    int count = 0;
+    {
+        linked_ptr<Snapshot> x(new Snapshot{&count});
+        std::vector<linked_ptr<Snapshot const>> v;
+        for (int i = 0; i < 10; ++i)
+            v.push_back(x);
+        x.reset();
+        ASSERT_EQ(v[0].use_count(), 10u);
+        v.resize(1);
+        ASSERT_TRUE(v[0].unique());
+        ASSERT_EQ(count, 0);
+    }
+    ASSERT_EQ(count, 1);
+}
+
+TEST(weak, lock_and_expire)
+{
+    int count = 0;
+    weak_linked_ptr<DestructionDetector> w;
+    ASSERT_TRUE(w.expired());
+    {
+        linked_ptr<DestructionDetector> x(new DestructionDetector(&count));
+        linked_ptr<DestructionDetector> y(x);
+        w = y;
+        ASSERT_FALSE(w.expired());
+        ASSERT_EQ(w.use_count(), 2u);
+        {
+            auto locked = w.lock();
+            ASSERT_EQ(locked, x);
+            ASSERT_EQ(x.use_count(), 3u);
+        }
+        x.reset();
+        ASSERT_TRUE(y.unique());
+        ASSERT_EQ(count, 0);
+    }
+    ASSERT_EQ(count, 1);
+    ASSERT_TRUE(w.expired());
+    ASSERT_EQ(w.use_count(), 0u);
+    ASSERT_FALSE(w.lock());
+}
+
+TEST(weak, make_linked)
+{
+    int count = 0;
+    weak_linked_ptr<DestructionDetector> w;
+    {
+        auto x = make_linked<DestructionDetector>(&count);
+        w = x;
+        weak_linked_ptr<DestructionDetector> copy(w);
+        ASSERT_EQ(copy.lock(), x);
+    }
+    ASSERT_EQ(count, 1);
+    ASSERT_TRUE(w.expired());
+}
+
+TEST(weak, counted_ring)
+{
+    int count = 0;
+    weak_linked_ptr<Snapshot> w;
+    {
+        linked_ptr<Snapshot> x(new Snapshot{&count});
+        std::vector<linked_ptr<Snapshot>> v(20, x);
+        w = x;
+        ASSERT_EQ(w.use_count(), 21u);
+        auto locked = w.lock();
+        ASSERT_EQ(x.use_count(), 22u);
+    }
+    ASSERT_EQ(count, 1);
+    ASSERT_TRUE(w.expired());
+}
+
+struct SelfObserver
+{
+    weak_linked_ptr<SelfObserver> self;
+};
+
+TEST(weak, observer_inside_object)
+{
+    auto x = make_linked<SelfObserver>();
+    x->self = x;
+    ASSERT_EQ(x->self.lock(), x);
+    x.reset();
+}
+
+TEST(weak, size)
+{
+    static_assert(sizeof(linked_ptr<int>) == 3 * sizeof(void*));
+    static_assert(sizeof(weak_linked_ptr<int>) == 2 * sizeof(void*));
+    SUCCEED();
+}
+
+struct Handler : enable_linked_from_this<Handler>
+{
+    int* cnt;
+
+    explicit Handler(int* cnt) : cnt(cnt) {}
+
+    ~Handler()
+    {
+        (*cnt)++;
+    }
+
+    linked_ptr<Handler> self()
+    {
+        return linked_from_this();
+    }
+};
+
+struct DerivedHandler : Handler
+{
+    using Handler::Handler;
+};
+
+TEST(linked_from_this, raw_pointer)
+{
+    int count = 0;
+    {
+        linked_ptr<Handler> x(new Handler(&count));
+        linked_ptr<Handler> y = x->self();
+        ASSERT_EQ(x, y);
+        ASSERT_EQ(x.use_count(), 2u);
+        x.reset();
+        ASSERT_TRUE(y.unique());
+        ASSERT_EQ(count, 0);
+    }
+    ASSERT_EQ(count, 1);
+}
+
+TEST(linked_from_this, make_linked)
+{
+    int count = 0;
+    {
+        auto x = make_linked<Handler>(&count);
+        auto y = x->self();
+        ASSERT_EQ(y.use_count(), 2u);
+        linked_ptr<Handler const> z = static_cast<Handler const&>(*x).linked_from_this();
+        ASSERT_EQ(z.use_count(), 3u);
+    }
+    ASSERT_EQ(count, 1);
+}
+
+TEST(linked_from_this, derived)
+{
+    int count = 0;
+    {
+        linked_ptr<DerivedHandler> x(new DerivedHandler(&count));
+        linked_ptr<Handler> y = x->self();
+        ASSERT_EQ(y.get(), x.get());
+        ASSERT_EQ(x.use_count(), 2u);
+        x.reset(new DerivedHandler(&count));
+        ASSERT_EQ(x->self().use_count(), 2u);
+    }
+    ASSERT_EQ(count, 2);
+}
+
+TEST(linked_from_this, not_owned)
+{
+    int count = 0;
+    Handler h(&count);
+    ASSERT_FALSE(h.self());
+    ASSERT_TRUE(h.weak_from_this().expired());
+}
+
+struct Message
+{
+    int* cnt;
+    int header;
+    int payload[4];
+
+    ~Message()
+    {
+        (*cnt)++;
+    }
+};
+
+TEST(aliasing, member)
+{
+    int count = 0;
+    linked_ptr<int> field;
+    {
+        linked_ptr<Message> x(new Message{&count, 7, {1, 2, 3, 4}});
+        field = linked_ptr<int>(x, &x->header);
+        ASSERT_EQ(*field, 7);
+        ASSERT_EQ(x.use_count(), 2u);
+    }
+    ASSERT_EQ(count, 0);
+    ASSERT_TRUE(field.unique());
+    field.reset();
+    ASSERT_EQ(count, 1);
+}
+
+TEST(aliasing, element_and_move)
+{
+    int count = 0;
+    {
+        auto x = make_linked<Message>(Message{&count, 7, {1, 2, 3, 4}});
+        count = 0;
+        linked_ptr<int> third(x, x->payload + 2);
+        linked_ptr<int> copy(third);
+        ASSERT_EQ(*copy, 3);
+        linked_ptr<int> moved(std::move(x), x->payload + 3);
+        ASSERT_FALSE(x);
+        ASSERT_EQ(*moved, 4);
+        ASSERT_EQ(moved.use_count(), 3u);
+        third.reset();
+        copy.reset();
+        ASSERT_EQ(count, 0);
+    }
+    ASSERT_EQ(count, 1);
+}
+
+TEST(aliasing, empty_owner)
+{
+    int value = 5;
+    linked_ptr<Message> empty;
+    linked_ptr<int> alias(empty, &value);
+    ASSERT_FALSE(alias);
+}
+
+TEST(arrays, raw_pointer)
+{
+    int count = 0;
+    {
+        linked_ptr<DestructionDetector[]> x(new DestructionDetector[3]{&count, &count, &count});
+        linked_ptr<DestructionDetector[]> y(x);
+        ASSERT_EQ(y[2].cnt, &count);
+        x.reset();
+        ASSERT_EQ(count, 0);
+    }
+    ASSERT_EQ(count, 3);
+}
+
+TEST(arrays, make_linked)
+{
+    linked_ptr<int[]> zeros = make_linked<int[]>(4);
+    for (int i = 0; i < 4; ++i)
+        ASSERT_EQ(zeros[i], 0);
+    linked_ptr<int[]> fives = make_linked<int[]>(3, 5);
+    ASSERT_EQ(fives[0] + fives[1] + fives[2], 15);
+    linked_ptr<int[8]> bounded = make_linked<int[8]>();
+    bounded[7] = 1;
+    ASSERT_EQ(bounded[7], 1);
+    linked_ptr<int const[]> view(fives);
+    ASSERT_EQ(view.use_count(), 2u);
+    ASSERT_EQ(make_linked<int[]>(0).get() != nullptr, true);
+}
+
+TEST(arrays, make_linked_destroys_elements)
+{
+    int count = 0;
+    {
+        linked_ptr<DestructionDetector[]> x = make_linked<DestructionDetector[]>(5, DestructionDetector(&count));
+        count = 0;
+        linked_ptr<DestructionDetector> element(x, &x[4]);
+        x.reset();
+        ASSERT_EQ(count, 0);
+        ASSERT_EQ(element->cnt, &count);
+    }
+    ASSERT_EQ(count, 5);
+}
+
+struct Shape
+{
+    int* cnt;
+
+    explicit Shape(int* cnt) : cnt(cnt) {}
+
+    virtual ~Shape()
+    {
+        (*cnt)++;
+    }
+};
+
+struct Circle : Shape
+{
+    using Shape::Shape;
+};
+
+struct Square : Shape
+{
+    using Shape::Shape;
+};
+
+TEST(casts, static_and_dynamic)
+{
+    int count = 0;
+    {
+        linked_ptr<Shape> shape(new Circle(&count));
+        linked_ptr<Circle> circle = static_linked_cast<Circle>(shape);
+        ASSERT_EQ(circle.get(), shape.get());
+        ASSERT_EQ(shape.use_count(), 2u);
+        ASSERT_FALSE(dynamic_linked_cast<Square>(shape));
+        linked_ptr<Circle> same = dynamic_linked_cast<Circle>(shape);
+        ASSERT_EQ(same.use_count(), 3u);
+        shape.reset();
+        circle.reset();
+        ASSERT_EQ(count, 0);
+    }
+    ASSERT_EQ(count, 1);
+}
+
+TEST(casts, rvalue_takes_over_slot)
+{
+    int count = 0;
+    {
+        linked_ptr<Shape> shape(new Circle(&count));
+        linked_ptr<Shape> other(shape);
+        linked_ptr<Circle> circle = dynamic_linked_cast<Circle>(std::move(shape));
+        ASSERT_FALSE(shape);
+        ASSERT_EQ(circle.use_count(), 2u);
+
+        linked_ptr<Square> square = dynamic_linked_cast<Square>(std::move(other));
+        ASSERT_FALSE(square);
+        ASSERT_TRUE(other);
+        ASSERT_EQ(circle.use_count(), 2u);
+    }
+    ASSERT_EQ(count, 1);
+}
+
+TEST(casts, const_and_reinterpret)
+{
+    int count = 0;
+    {
+        linked_ptr<int const> constant(new int(5));
+        linked_ptr<int> mutable_value = const_linked_cast<int>(constant);
+        *mutable_value = 6;
+        ASSERT_EQ(*constant, 6);
+        ASSERT_EQ(constant.use_count(), 2u);
+
+        linked_ptr<int, CountingDeleter> value(new int(5), CountingDeleter{&count});
+        linked_ptr<int const> view = const_linked_cast<int const>(value);
+        linked_ptr<unsigned char const> bytes = reinterpret_linked_cast<unsigned char const>(std::move(view));
+        ASSERT_FALSE(view);
+        ASSERT_EQ(value.use_count(), 2u);
+        value.reset();
+        ASSERT_EQ(count, 0);
+    }
+    ASSERT_EQ(count, 1);
+}
+
+struct Tracked
+{
+    int value = 0;
+};
+
+struct TrackedAcrossThreads
+{
+    int value = 0;
+};
+
+struct TrackedSampled
+{
+    int value = 0;
+};
+
+struct TrackedReleased
+{
+    int value = 0;
+};
+
+namespace smart_ptr
+{
+    template <>
+    struct linked_ptr_traits<Tracked>
+    {
+        static constexpr std::size_t promotion_threshold = 0;
+        static constexpr bool demote = true;
+        static constexpr bool collect_stats = true;
+    };
+
+    template <>
+    struct linked_ptr_traits<TrackedAcrossThreads>
+    {
+        static constexpr std::size_t promotion_threshold = 0;
+        static constexpr bool demote = true;
+        static constexpr bool collect_stats = true;
+    };
+
+    template <>
+    struct linked_ptr_traits<TrackedSampled>
+    {
+        static constexpr std::size_t promotion_threshold = 0;
+        static constexpr bool demote = true;
+        static constexpr bool collect_stats = true;
+    };
+
+    template <>
+    struct linked_ptr_traits<TrackedReleased>
+    {
+        static constexpr std::size_t promotion_threshold = 0;
+        static constexpr bool demote = true;
+        static constexpr bool collect_stats = true;
+    };
+}
+
+// Counters are never reset, so tests look at what they added.
+ring_stats stats_added(ring_stats const& before, ring_stats after)
+{
+    after.constructions -= before.constructions;
+    after.attaches -= before.attaches;
+    after.detaches -= before.detaches;
+    after.unlink_writes -= before.unlink_writes;
+    after.swaps -= before.swaps;
+    after.deletes -= before.deletes;
+    for (std::size_t i = 0; i < ring_stats::histogram_size; ++i)
+        after.ring_length_histogram[i] -= before.ring_length_histogram[i];
+    return after;
+}
+
+std::size_t samples(ring_stats const& stats)
+{
+    std::size_t total = 0;
+    for (std::size_t n : stats.ring_length_histogram)
+        total += n;
+    return total;
+}
+
+TEST(stats, counts_ring_operations)
+{
+    ring_stats before = linked_ptr_stats<Tracked>();
+    {
+        linked_ptr<Tracked> x(new Tracked());
+        std::vector<linked_ptr<Tracked>> copies(5, x);
+        linked_ptr<Tracked> y = make_linked<Tracked>();
+        x.swap(y);
+        copies.pop_back();
+    }
+    ring_stats stats = stats_added(before, linked_ptr_stats<Tracked>());
+    ASSERT_EQ(stats.constructions, 2u);
+    ASSERT_EQ(stats.attaches, 5u);
+    ASSERT_EQ(stats.swaps, 1u);
+    ASSERT_EQ(stats.deletes, 2u);
+    ASSERT_EQ(stats.detaches, 5u);
+    // Lengths are sampled: the rings had 2 to 6 owners, and a walk over n
+    // owners is followed by n copies without one, possibly left over from
+    // an earlier test.
+    ASSERT_LE(samples(stats), 2u);
+    ASSERT_EQ(stats.ring_length_histogram[0], 0u);
+    ASSERT_EQ(stats.ring_length_histogram[1] + stats.ring_length_histogram[2], samples(stats));
+    ASSERT_GE(stats.peak_ring_length, 2u);
+    ASSERT_LE(stats.peak_ring_length, 6u);
+}
+
+TEST(stats, samples_uncounted_rings)
+{
+    ring_stats before = linked_ptr_stats<TrackedSampled>();
+    {
+        linked_ptr<TrackedSampled> x(new TrackedSampled());
+        std::vector<linked_ptr<TrackedSampled>> copies(1000, x);
+    }
+    ring_stats stats = stats_added(before, linked_ptr_stats<TrackedSampled>());
+    ASSERT_EQ(stats.attaches, 1000u);
+    ASSERT_LE(samples(stats), 11u);
+    ASSERT_GE(stats.peak_ring_length, 512u);
+    ASSERT_LE(stats.peak_ring_length, 1001u);
+}
+
+TEST(stats, aggregates_threads)
+{
+    ring_stats before = linked_ptr_stats<TrackedAcrossThreads>();
+    linked_ptr<TrackedAcrossThreads> x(new TrackedAcrossThreads());
+    std::thread finished([&x]
+    {
+        linked_ptr<TrackedAcrossThreads> copy(x);
+    });
+    finished.join();
+    linked_ptr<TrackedAcrossThreads> copy(x);
+    ring_stats stats = stats_added(before, linked_ptr_stats<TrackedAcrossThreads>());
+    ASSERT_EQ(stats.constructions, 1u);
+    ASSERT_EQ(stats.attaches, 2u);
+    ASSERT_EQ(stats.detaches, 1u);
+    ASSERT_EQ(linked_ptr_stats<int>().attaches, 0u);
+}
+
+struct Deferred
+{
+    int* cnt;
+
+    ~Deferred()
+    {
+        (*cnt)++;
+    }
+};
+
+namespace smart_ptr
+{
+    template <>
+    struct linked_ptr_traits<Deferred>
+    {
+        static constexpr std::size_t promotion_threshold = 4;
+        static constexpr bool demote = true;
+        static constexpr bool defer_destruction = true;
+    };
+}
+
+TEST(deferred, destroyed_when_drained)
+{
+    int count = 0;
+    {
+        linked_ptr<Deferred> x(new Deferred{&count});
+        linked_ptr<Deferred> y(x);
+    }
+    ASSERT_EQ(count, 0);
+    ASSERT_EQ(deferred_count(), 1u);
+    ASSERT_EQ(drain_deferred(), 1u);
+    ASSERT_EQ(count, 1);
+    ASSERT_EQ(deferred_count(), 0u);
+}
+
+TEST(deferred, weak_expires_at_release)
+{
+    int count = 0;
+    weak_linked_ptr<Deferred> w;
+    {
+        auto x = make_linked<Deferred>(Deferred{&count});
+        count = 0;
+        w = x;
+    }
+    ASSERT_TRUE(w.expired());
+    ASSERT_FALSE(w.lock());
+    ASSERT_EQ(count, 0);
+    drain_deferred();
+    ASSERT_EQ(count, 1);
+}
+
+TEST(deferred, counted_rings_and_limit)
+{
+    int count = 0;
+    {
+        linked_ptr<Deferred> x(new Deferred{&count});
+        std::vector<linked_ptr<Deferred>> v(10, x);
+        linked_ptr<Deferred> y(new Deferred{&count});
+    }
+    ASSERT_EQ(deferred_count(), 2u);
+    ASSERT_EQ(drain_deferred(1), 1u);
+    ASSERT_EQ(count, 1);
+    ASSERT_EQ(drain_deferred(5), 1u);
+    ASSERT_EQ(count, 2);
+}
+
+TEST(deferred, released_after_thread_exit)
+{
+    int count = 0;
+    std::thread exiting([&count]
+    {
+        // Constructed before the queue, so destroyed after it.
+        thread_local linked_ptr<Deferred> late;
+        late.reset(new Deferred{&count});
+        ASSERT_EQ(deferred_count(), 0u);
+    });
+    exiting.join();
+    ASSERT_EQ(count, 1);
+}
+
+struct Reclaimed
+{
+    std::atomic<int>* cnt;
+    std::thread::id* destroyed_on;
+
+    ~Reclaimed()
+    {
+        if (destroyed_on)
+            *destroyed_on = std::this_thread::get_id();
+        (*cnt)++;
+    }
+};
+
+namespace smart_ptr
+{
+    template <>
+    struct linked_ptr_traits<Reclaimed>
+    {
+        static constexpr std::size_t promotion_threshold = 0;
+        static constexpr bool demote = true;
+        static constexpr bool defer_destruction = true;
+    };
+}
+
+TEST(reclaimer, destroys_on_its_thread)
+{
+    std::atomic<int> count{0};
+    std::thread::id destroyed_on;
+    reclaimer background(4);
+    background.install();
+    for (int i = 0; i < 10; ++i)
+        linked_ptr<Reclaimed>(new Reclaimed{&count, &destroyed_on});
+    auto last = make_linked<Reclaimed>();
+    last->cnt = &count;
+    last->destroyed_on = nullptr;
+    last.reset();
+    background.flush();
+    ASSERT_EQ(count.load(), 11);
+    ASSERT_NE(destroyed_on, std::this_thread::get_id());
+    ASSERT_EQ(background.pending(), 0u);
+    ASSERT_EQ(deferred_count(), 0u);
+}
+
+TEST(reclaimer, keeps_observed_objects)
+{
+    std::atomic<int> count{0};
+    reclaimer background;
+    background.install();
+    weak_linked_ptr<Reclaimed> w;
+    {
+        linked_ptr<Reclaimed> x(new Reclaimed{&count, nullptr});
+        w = x;
+    }
+    background.flush();
+    ASSERT_TRUE(w.expired());
+    ASSERT_EQ(count.load(), 0);
+    ASSERT_EQ(drain_deferred(), 1u);
+    ASSERT_EQ(count.load(), 1);
+}
+
+TEST(reclaimer, executor_and_backpressure)
+{
+    std::atomic<int> count{0};
+    std::vector<std::function<void()>> tasks;
+    {
+        reclaimer queued([&tasks](std::function<void()> task)
+        {
+            tasks.push_back(std::move(task));
+        }, 2, 4, reclaim_overflow::destroy_inline);
+        queued.install();
+        for (int i = 0; i < 6; ++i)
+            linked_ptr<Reclaimed>(new Reclaimed{&count, nullptr});
+        ASSERT_EQ(tasks.size(), 1u);
+        ASSERT_EQ(queued.pending(), 4u);
+        ASSERT_EQ(count.load(), 2);
+        tasks.front()();
+        ASSERT_EQ(count.load(), 6);
+        queued.flush();
+    }
+    ASSERT_EQ(tasks.size(), 1u);
+}
+
+TEST(region, released_by_reclaimer)
+{
+    CountingResource upstream;
+    std::atomic<int> count{0};
+    {
+        reclaimer background(1);
+        background.install();
+        {
+            linked_region region(256, &upstream);
+            for (int i = 0; i < 100; ++i)
+            {
+                auto x = region.make<Reclaimed>();
+                x->cnt = &count;
+                x->destroyed_on = nullptr;
+            }
+        }
+        background.flush();
+    }
+    ASSERT_EQ(count.load(), 100);
+    ASSERT_GT(upstream.allocations, 1);
+    ASSERT_EQ(upstream.deallocations, upstream.allocations);
+}
+
+
+TEST(vector, growth_keeps_rings)
+{
+    int count = 0;
+    {
+        linked_ptr<DestructionDetector> outside(new DestructionDetector(&count));
+        linked_ptr_vector<DestructionDetector> v;
+        for (int i = 0; i < 100; ++i)
+        {
+            if (i % 3 == 0)
+                v.push_back(outside);
+            else if (i % 3 == 1)
+                v.emplace_back(new DestructionDetector(&count));
+            else
+                v.push_back(v.back());
+        }
+        ASSERT_EQ(v.size(), 100u);
+        ASSERT_EQ(outside.use_count(), 35u);
+        ASSERT_EQ(v[1].use_count(), 2u);
+        outside.reset();
+        ASSERT_EQ(count, 0);
+        ASSERT_EQ(v[0].use_count(), 34u);
+    }
+    ASSERT_EQ(count, 34);
+}
+
+TEST(vector, insert_erase)
+{
+    int count = 0;
+    {
+        linked_ptr<DestructionDetector> x(new DestructionDetector(&count));
+        linked_ptr_vector<DestructionDetector> v;
+        v.reserve(8);
+        v.push_back(x);
+        v.push_back(x);
+        v.insert(v.begin(), linked_ptr<DestructionDetector>(new DestructionDetector(&count)));
+        v.insert(v.begin() + 1, v[2]);
+        ASSERT_EQ(x.use_count(), 4u);
+        v.erase(v.begin());
+        ASSERT_EQ(count, 1);
+        v.erase(v.begin(), v.begin() + 2);
+        ASSERT_EQ(v.size(), 1u);
+        ASSERT_EQ(x.use_count(), 2u);
+        linked_ptr_vector<DestructionDetector> copy(v);
+        ASSERT_EQ(x.use_count(), 3u);
+        v.shrink_to_fit();
+        x.reset();
+        copy.clear();
+        ASSERT_EQ(v[0].use_count(), 1u);
+    }
+    ASSERT_EQ(count, 2);
+}
+
+TEST(vector, counted_and_headed_rings)
+{
+    int count = 0;
+    {
+        linked_ptr_vector<Snapshot> v;
+        v.emplace_back(new Snapshot{&count});
+        for (int i = 0; i < 10; ++i)
+            v.push_back(v[0]);
+        linked_ptr<int> value = make_linked<int>(5);
+        linked_ptr_vector<int> values;
+        for (int i = 0; i < 10; ++i)
+            values.insert(values.begin(), value);
+        ASSERT_EQ(v[10].use_count(), 11u);
+        ASSERT_EQ(value.use_count(), 11u);
+        values.erase(values.begin() + 3);
+        ASSERT_EQ(value.use_count(), 10u);
+        v.erase(v.begin(), v.begin() + 10);
+        ASSERT_EQ(v[0].use_count(), 1u);
+    }
+    ASSERT_EQ(count, 1);
+}
+
+// Values of the owners, in order.
+std::vector<int> values(std::vector<linked_ptr<int>> const& v)
+{
+    std::vector<int> result;
+    for (auto const& p : v)
+        result.push_back(*p);
+    return result;
+}
+
+TEST(algorithms, rotate)
+{
+    linked_ptr<int> outside(new int(0));
+    std::vector<linked_ptr<int>> v;
+    for (int i = 0; i < 10; ++i)
+        v.push_back(i % 2 ? outside : linked_ptr<int>(new int(i)));
+    linked_ptr<int> shared = v[2];
+    v[7] = shared;
+    auto* result = smart_ptr::rotate(v.data(), v.data() + 3, v.data() + 10);
+    ASSERT_EQ(result, v.data() + 7);
+    ASSERT_EQ(values(v), (std::vector<int>{0, 4, 0, 6, 2, 8, 0, 0, 0, 2}));
+    ASSERT_EQ(outside.use_count(), 5u);
+    ASSERT_EQ(shared.use_count(), 3u);
+    smart_ptr::rotate(v.data(), v.data() + 8, v.data() + 10);
+    ASSERT_EQ(values(v), (std::vector<int>{0, 2, 0, 4, 0, 6, 2, 8, 0, 0}));
+    v.clear();
+    ASSERT_TRUE(outside.unique());
+    ASSERT_TRUE(shared.unique());
+}
+
+TEST(algorithms, swap_ranges)
+{
+    int count = 0;
+    {
+        linked_ptr<DestructionDetector> x(new DestructionDetector(&count));
+        std::vector<linked_ptr<DestructionDetector>> a(100, x);
+        std::vector<linked_ptr<DestructionDetector>> b;
+        for (int i = 0; i < 100; ++i)
+            b.emplace_back(i % 2 ? a[i] : linked_ptr<DestructionDetector>(new DestructionDetector(&count)));
+        smart_ptr::swap_ranges(a.data(), a.data() + 100, b.data());
+        ASSERT_EQ(x.use_count(), 151u);
+        ASSERT_EQ(a[0].use_count(), 1u);
+        ASSERT_EQ(b[99].get(), x.get());
+        a.clear();
+        ASSERT_EQ(count, 50);
+    }
+    ASSERT_EQ(count, 51);
+}
+
+TEST(algorithms, sort)
+{
+    std::vector<linked_ptr<int>> v;
+    std::vector<linked_ptr<int>> keep;
+    for (int i = 0; i < 200; ++i)
+    {
+        int value = (i * 37) % 50;
+        if (i >= 50)
+            v.push_back(v[static_cast<std::size_t>(i % 50)]);
+        else
+            v.emplace_back(new int(value));
+        if (i % 7 == 0)
+            keep.push_back(v.back());
+    }
+    smart_ptr::sort(v.data(), v.data() + v.size(), [](linked_ptr<int> const& a, linked_ptr<int> const& b)
+    {
+        return *a < *b;
+    });
+    ASSERT_TRUE(std::is_sorted(v.begin(), v.end(), [](linked_ptr<int> const& a, linked_ptr<int> const& b)
+    {
+        return *a < *b;
+    }));
+    for (auto const& p : v)
+        ASSERT_EQ(p.use_count(), static_cast<std::size_t>(4 + std::count(keep.begin(), keep.end(), p)));
+    smart_ptr::sort(v.data(), v.data() + v.size());
+    ASSERT_TRUE(std::is_sorted(v.begin(), v.end()));
+    v.clear();
+    for (auto const& p : keep)
+        ASSERT_EQ(p.use_count(), static_cast<std::size_t>(std::count(keep.begin(), keep.end(), p)));
+}
+
+TEST(algorithms, sort_with_stateful_deleter)
+{
+    int count = 0;
+    {
+        using deleter = std::function<void(int*)>;
+        deleter counting = [&count](int* p)
+        {
+            ++count;
+            delete p;
+        };
+        std::vector<linked_ptr<int, deleter>> v;
+        for (int i = 0; i < 20; ++i)
+            v.emplace_back(new int((i * 7) % 20), counting);
+        linked_ptr<int, deleter> kept = v[3];
+        smart_ptr::sort(v.data(), v.data() + v.size(), [](auto const& a, auto const& b)
+        {
+            return *a < *b;
+        });
+        for (int i = 0; i < 20; ++i)
+            ASSERT_EQ(*v[static_cast<std::size_t>(i)], i);
+        ASSERT_EQ(kept.use_count(), 2u);
+        smart_ptr::rotate(v.data(), v.data() + 5, v.data() + 20);
+        ASSERT_EQ(*v[0], 5);
+    }
+    ASSERT_EQ(count, 20);
+}
+
+TEST(algorithms, reset_range_shared_rings)
+{
+    int count = 0;
+    {
+        linked_ptr<DestructionDetector> outside(new DestructionDetector(&count));
+        linked_ptr<DestructionDetector> inside = make_linked<DestructionDetector>(&count);
+        std::vector<linked_ptr<DestructionDetector>> v;
+        for (int i = 0; i < 30; ++i)
+        {
+            if (i % 5 == 0)
+                v.push_back(outside);
+            else if (i % 5 == 1)
+                v.push_back(inside);
+            else if (i % 5 == 2)
+                v.emplace_back(new DestructionDetector(&count));
+            else
+                v.push_back(v[static_cast<std::size_t>(i - 1)]);
+        }
+        linked_ptr<DestructionDetector> middle(v[0]);
+        v.push_back(outside);
+        inside.reset();
+        smart_ptr::clear(v);
+        ASSERT_EQ(count, 7);
+        ASSERT_EQ(outside.use_count(), 2u);
+        ASSERT_EQ(middle.use_count(), 2u);
+    }
+    ASSERT_EQ(count, 8);
+}
+
+TEST(algorithms, reset_range_reversed_ring)
+{
+    int count = 0;
+    {
+        linked_ptr<DestructionDetector> x(new DestructionDetector(&count));
+        std::vector<linked_ptr<DestructionDetector>> v(1, x);
+        for (int i = 0; i < 9; ++i)
+            v.push_back(v.back());
+        linked_ptr<DestructionDetector> middle(v[4]);
+        std::reverse(v.begin(), v.end());
+        smart_ptr::reset_range(v.data() + 1, v.data() + 9);
+        ASSERT_EQ(x.use_count(), 4u);
+        ASSERT_FALSE(v[5]);
+        x.reset();
+        middle.reset();
+        smart_ptr::clear(v);
+        ASSERT_EQ(count, 1);
+    }
+    ASSERT_EQ(count, 1);
+}
+
+TEST(algorithms, reset_range_splices_runs)
+{
+    linked_ptr<TrackedReleased> x(new TrackedReleased());
+    linked_ptr<TrackedReleased> y(x);
+    // Copies of x go right after it, between x and y.
+    std::vector<linked_ptr<TrackedReleased>> spliced(8, x);
+    std::vector<linked_ptr<TrackedReleased>> released(8, x);
+    ring_stats before = linked_ptr_stats<TrackedReleased>();
+    smart_ptr::reset_range(spliced.data(), spliced.data() + spliced.size());
+    ring_stats stats = stats_added(before, linked_ptr_stats<TrackedReleased>());
+    ASSERT_EQ(stats.detaches, 8u);
+    ASSERT_EQ(stats.unlink_writes, 2u);
+    before = linked_ptr_stats<TrackedReleased>();
+    for (auto& owner : released)
+        owner.reset();
+    stats = stats_added(before, linked_ptr_stats<TrackedReleased>());
+    ASSERT_EQ(stats.detaches, 8u);
+    ASSERT_EQ(stats.unlink_writes, 16u);
+    ASSERT_EQ(x.use_count(), 2u);
+    // A run that is the whole ring is released by its last owner.
+    std::vector<linked_ptr<TrackedReleased>> last(4, x);
+    x.reset();
+    y.reset();
+    before = linked_ptr_stats<TrackedReleased>();
+    smart_ptr::reset_range(last.data(), last.data() + last.size());
+    stats = stats_added(before, linked_ptr_stats<TrackedReleased>());
+    ASSERT_EQ(stats.detaches, 3u);
+    ASSERT_EQ(stats.deletes, 1u);
+    ASSERT_EQ(stats.unlink_writes, 0u);
+    ASSERT_FALSE(last[3]);
+}
+
+TEST(algorithms, destroy_range_counted)
+{
+    int count = 0;
+    {
+        linked_ptr_vector<Snapshot> v;
+        v.emplace_back(new Snapshot{&count});
+        for (int i = 0; i < 10; ++i)
+            v.push_back(v[0]);
+        linked_ptr<Snapshot> kept(v[4]);
+        v.erase(v.begin() + 2, v.begin() + 8);
+        ASSERT_EQ(kept.use_count(), 6u);
+        v.clear();
+        ASSERT_EQ(count, 0);
+        ASSERT_TRUE(kept.unique());
+    }
+    ASSERT_EQ(count, 1);
+}
+
+TEST(concurrent, copy_destroy)
+{
+    int count = 0;
+    {
+        concurrent_linked_ptr<DestructionDetector> root(new DestructionDetector(&count));
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 8; ++t)
+        {
+            threads.emplace_back([root]
+            {
+                std::vector<concurrent_linked_ptr<DestructionDetector>> local;
+                for (int i = 0; i < 2000; ++i)
+                {
+                    local.push_back(root);
+                    if (i % 3 == 0 && local.size() > 1)
+                        local.erase(local.begin() + i % local.size());
+                    concurrent_linked_ptr<DestructionDetector> moved(std::move(local.back()));
+                    local.back() = moved;
+                }
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        ASSERT_TRUE(root.unique());
+        ASSERT_EQ(count, 0);
+    }
+    ASSERT_EQ(count, 1);
+}
+
+TEST(concurrent, last_owner_in_other_thread)
+{
+    for (int round = 0; round < 100; ++round)
+    {
+        int count = 0;
+        concurrent_linked_ptr<DestructionDetector> x(new DestructionDetector(&count));
+        concurrent_linked_ptr<DestructionDetector> y(x);
+        std::thread thread([moved = std::move(y)]() mutable { moved.reset(); });
+        x.reset();
+        thread.join();
+        ASSERT_EQ(count, 1);
+    }
+}
+
+TEST(atomic, load_store_exchange)
+{
+    int count = 0;
+    {
+        atomic_linked_ptr<DestructionDetector> slot;
+        ASSERT_FALSE(slot.load());
+        concurrent_linked_ptr<DestructionDetector> first(new DestructionDetector(&count));
+        slot.store(first);
+        ASSERT_EQ(slot.load(), first);
+        ASSERT_EQ(first.use_count(), 2u);
+        auto previous = slot.exchange(concurrent_linked_ptr<DestructionDetector>(new DestructionDetector(&count)));
+        ASSERT_EQ(previous, first);
+        previous.reset();
+        first.reset();
+        ASSERT_EQ(count, 1);
+
+        concurrent_linked_ptr<DestructionDetector> expected;
+        ASSERT_FALSE(slot.compare_exchange_strong(expected, concurrent_linked_ptr<DestructionDetector>()));
+        ASSERT_TRUE(expected);
+        ASSERT_TRUE(slot.compare_exchange_strong(expected, concurrent_linked_ptr<DestructionDetector>()));
+        expected.reset();
+        ASSERT_EQ(count, 2);
+        ASSERT_FALSE(slot.load());
+    }
+}
+
+TEST(atomic, readers_and_writers)
+{
+    std::atomic<int> count{0};
+    struct Counted
+    {
+        std::atomic<int>* cnt;
+        int value;
+
+        ~Counted()
+        {
+            (*cnt)++;
+        }
+    };
+    {
+        atomic_linked_ptr<Counted> slot(concurrent_linked_ptr<Counted>(new Counted{&count, 0}));
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&slot]
+            {
+                for (int i = 0; i < 2000; ++i)
+                {
+                    auto current = slot.load();
+                    ASSERT_TRUE(current);
+                    ASSERT_GE(current->value, 0);
+                }
+            });
+        }
+        for (int t = 0; t < 2; ++t)
+        {
+            threads.emplace_back([&slot, &count, t]
+            {
+                for (int i = 1; i <= 500; ++i)
+                {
+                    auto expected = slot.load();
+                    concurrent_linked_ptr<Counted> desired(new Counted{&count, t * 1000 + i});
+                    while (!slot.compare_exchange_weak(expected, desired))
+                        ;
+                }
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        ASSERT_EQ(count.load(), 1000);
+    }
+    ASSERT_EQ(count.load(), 1001);
+}
+
+TEST(lockfree, copy_destroy)
+{
+    int count = 0;
+    {
+        lockfree_linked_ptr<DestructionDetector> root(new DestructionDetector(&count));
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 8; ++t)
+        {
+            threads.emplace_back([root]
+            {
+                std::vector<lockfree_linked_ptr<DestructionDetector>> local;
+                for (int i = 0; i < 2000; ++i)
+                {
+                    local.push_back(root);
+                    if (i % 3 == 0 && local.size() > 1)
+                        local.erase(local.begin() + i % local.size());
+                }
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        ASSERT_TRUE(root.unique());
+        ASSERT_EQ(count, 0);
+    }
+    ASSERT_EQ(count, 1);
+}
+
+TEST(lockfree, interface)
+{
+    int count = 0;
+    {
+        lockfree_linked_ptr<Base> x(new Derived(5, 6));
+        lockfree_linked_ptr<Base> y(x);
+        ASSERT_EQ(x.use_count(), 2u);
+        ASSERT_EQ(y->result(), 6);
+        lockfree_linked_ptr<DestructionDetector> z(new DestructionDetector(&count));
+        auto w = std::move(z);
+        ASSERT_FALSE(z);
+        ASSERT_TRUE(w.unique());
+        w.reset();
+        ASSERT_EQ(count, 1);
+    }
+}
+
+TEST(lockfree, last_owners_race)
+{
+    for (int round = 0; round < 200; ++round)
+    {
+        int count = 0;
+        std::vector<lockfree_linked_ptr<DestructionDetector>> owners;
+        owners.emplace_back(new DestructionDetector(&count));
+        for (int i = 0; i < 3; ++i)
+            owners.push_back(owners.front());
+        std::vector<std::thread> threads;
+        for (auto& owner : owners)
+        {
+            threads.emplace_back([owner = std::move(owner)]() mutable
+            {
+                lockfree_linked_ptr<DestructionDetector> copy(owner);
+                owner.reset();
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        ASSERT_EQ(count, 1);
+    }
+}
+
+TEST(lockfree, interleaved_teardown)
+{
+    int count = 0;
+    std::vector<lockfree_linked_ptr<DestructionDetector>> owners;
+    owners.emplace_back(new DestructionDetector(&count));
+    for (int i = 1; i < 4000; ++i)
+        owners.push_back(owners[static_cast<std::size_t>(i / 2)]);
+    for (std::size_t i = 0; i < owners.size(); i += 7)
+        owners[i].reset();
+    ASSERT_EQ(owners[1].use_count(), 4000u - 572u);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&owners, t]
+        {
+            for (std::size_t i = t; i < owners.size(); i += 4)
+                owners[i].reset();
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    ASSERT_EQ(count, 1);
+}
+
+TEST(pointer_using_interface, arrow)
+{
+    linked_ptr<std::pair<int, int> > x(new std::pair<int, int>(2, 4));
+    ASSERT_EQ(x->first, 2);
+    ASSERT_EQ(x->second, 4);
+}
+
+TEST(pointer_using_interface, star)
+{
+    int * x = new int(5);
+    linked_ptr<int> y(x);
+    ASSERT_EQ(*y, 5);
+}
+
+TEST(comparison, eq)
+{
+    int * x = new int(5);
+    linked_ptr<int> y(x);
+    linked_ptr<int> z(y);
+    ASSERT_TRUE(y == z);
+    ASSERT_FALSE(y != z);
+
+    y.reset(new int(6));
+    ASSERT_FALSE(y == z);
+    ASSERT_TRUE(y != z);
+}
+
+TEST(comparison, set)
+{
+    std::set<linked_ptr<int> > q;
+    q.insert(linked_ptr<int>(new int(5)));
+    q.insert(linked_ptr<int>(new int(5)));
+    q.insert(linked_ptr<int>(new int(6)));
+    q.insert(linked_ptr<int>(*q.begin()));
+    ASSERT_EQ(q.size(), 3);
+}
+
+TEST(comparison, set_greater)
+{
+    std::set<linked_ptr<int>, std::greater<linked_ptr<int>> > q;
+    q.insert(linked_ptr<int>(new int(5)));
+    q.insert(linked_ptr<int>(new int(5)));
+    q.insert(linked_ptr<int>(new int(6)));
+    q.insert(linked_ptr<int>(*q.begin()));
+    ASSERT_EQ(q.size(), 3);
+}
+
+TEST(comparison, hash)
+{
+    std::unordered_set<linked_ptr<int>> q;
+    linked_ptr<int> x(new int(5));
+    q.insert(x);
+    q.insert(linked_ptr<int>(x));
+    q.insert(linked_ptr<int>(new int(5)));
+    ASSERT_EQ(q.size(), 2u);
+    ASSERT_EQ(std::hash<linked_ptr<int>>()(x), std::hash<int*>()(x.get()));
+    ASSERT_EQ(linked_ptr_hash()(x), linked_ptr_hash()(x.get()));
+    ASSERT_TRUE(linked_ptr_equal_to()(x.get(), x));
+}
+
+TEST(comparison, transparent_lookup)
+{
+    std::set<linked_ptr<Base>, linked_ptr_less> q;
+    linked_ptr<Derived> x(new Derived(1, 2));
+    q.insert(x);
+    q.insert(linked_ptr<Base>(new Base(3)));
+    ASSERT_EQ(x.use_count(), 2u);
+    Base* raw = x.get();
+    auto it = q.find(raw);
+    ASSERT_TRUE(it != q.end());
+    ASSERT_EQ(x.use_count(), 2u);
+    ASSERT_EQ(q.count(x), 1u);
+    int other = 0;
+    ASSERT_TRUE(q.find(&other) == q.end());
+}
+
+struct Left
+{
+    int left = 1;
+    virtual ~Left() = default;
+};
+
+struct Right
+{
+    int right = 2;
+    virtual ~Right() = default;
+};
+
+struct Both : Left, Right {};
+
+TEST(comparison, lookup_adjusts_to_base)
+{
+    std::set<linked_ptr<Right>, linked_ptr_less> q;
+    Both* raw = new Both();
+    q.insert(linked_ptr<Right>(linked_ptr<Both>(raw)));
+    q.insert(linked_ptr<Right>(new Right()));
+    ASSERT_NE(static_cast<void*>(raw), static_cast<void*>(static_cast<Right*>(raw)));
+    auto it = q.find(raw);
+    ASSERT_TRUE(it != q.end());
+    ASSERT_EQ(it->get(), static_cast<Right*>(raw));
+    ASSERT_TRUE(linked_ptr_equal_to()(*it, raw));
+    ASSERT_FALSE(linked_ptr_less()(*it, raw));
+    ASSERT_FALSE(linked_ptr_less()(raw, *it));
 }
 
 struct A {